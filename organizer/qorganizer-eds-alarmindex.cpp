@@ -0,0 +1,533 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-alarmindex.h"
+#include "qorganizer-eds-enginedata.h"
+#include "qorganizer-eds-engineid.h"
+#include "qorganizer-eds-seriesexpansion.h"
+#include "qorganizer-eds-source-registry.h"
+#include "qorganizer-eds-viewwatcher.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+
+// extra time (secs) indexed after the requested window, avoids rebuilding the
+// index for clients that poll a moving window
+#define ALARM_INDEX_LOOKAHEAD (24 * 60 * 60)
+
+using namespace QtOrganizer;
+
+AlarmIndex::AlarmIndex(QOrganizerEDSEngineData *data)
+    : m_data(data),
+      m_eventLoop(0),
+      m_windowStart(0),
+      m_windowEnd(0),
+      m_valid(false)
+{
+}
+
+AlarmIndex::~AlarmIndex()
+{
+    Q_FOREACH(const QString &collectionId, m_cancellables.keys()) {
+        cancelFetches(collectionId);
+    }
+}
+
+bool AlarmIndex::isValid() const
+{
+    return m_valid;
+}
+
+void AlarmIndex::invalidate()
+{
+    Q_FOREACH(const QString &collectionId, m_cancellables.keys()) {
+        cancelFetches(collectionId);
+    }
+    m_triggers.clear();
+    m_valid = false;
+}
+
+QList<AlarmIndex::Alarm> AlarmIndex::alarms(const QDateTime &start, const QDateTime &end)
+{
+    time_t startTime = start.toTime_t();
+    time_t endTime = end.toTime_t();
+    if (!m_valid || (startTime < m_windowStart) || (endTime > m_windowEnd)) {
+        build(startTime, endTime + ALARM_INDEX_LOOKAHEAD);
+    }
+
+    QMultiMap<time_t, QOrganizerItemId> sorted;
+    Q_FOREACH(const QHash<QString, Series> &collection, m_triggers) {
+        Q_FOREACH(const Series &series, collection) {
+            QList<Trigger> triggers = series.master;
+            Q_FOREACH(const QList<Trigger> &instance, series.instances) {
+                triggers += instance;
+            }
+            Q_FOREACH(const Trigger &trigger, triggers) {
+                if ((trigger.trigger >= startTime) && (trigger.trigger < endTime)) {
+                    sorted.insert(trigger.trigger, trigger.itemId);
+                }
+            }
+        }
+    }
+
+    QList<Alarm> result;
+    for (QMultiMap<time_t, QOrganizerItemId>::const_iterator i = sorted.constBegin();
+         i != sorted.constEnd(); ++i) {
+        result << qMakePair(i.value(), QDateTime::fromTime_t(i.key()));
+    }
+    return result;
+}
+
+void AlarmIndex::build(time_t start, time_t end)
+{
+    invalidate();
+    m_windowStart = start;
+    m_windowEnd = end;
+    m_valid = true;
+
+    gchar *startStr = isodate_from_time_t(start);
+    gchar *endStr = isodate_from_time_t(end);
+    QByteArray query = QString("(has-alarms-in-range? (make-time \"%1\") (make-time \"%2\"))")
+            .arg(startStr)
+            .arg(endStr).toUtf8();
+    g_free(startStr);
+    g_free(endStr);
+
+    // only the watched collections are kept up to date, their clients are
+    // already connected
+    Q_FOREACH(const QString &collectionId, m_data->m_sourceRegistry->collectionsIds()) {
+        ViewWatcher *watcher = m_data->watcher(collectionId);
+        if (!watcher || !watcher->client()) {
+            continue;
+        }
+
+        m_building << collectionId;
+        CollectionFetch *fetch = collectionFetch(collectionId);
+        e_cal_client_get_object_list_as_comps(watcher->client(),
+                                              query.constData(),
+                                              fetch->cancellable,
+                                              (GAsyncReadyCallback) AlarmIndex::onAlarmsListed,
+                                              fetch);
+    }
+
+    if (!m_building.isEmpty()) {
+        QEventLoop eventLoop;
+        m_eventLoop = &eventLoop;
+        eventLoop.exec();
+        m_eventLoop = 0;
+    }
+}
+
+void AlarmIndex::buildDone(const QString &collectionId)
+{
+    m_building.remove(collectionId);
+    if (m_building.isEmpty() && m_eventLoop) {
+        m_eventLoop->quit();
+    }
+}
+
+AlarmIndex::CollectionFetch *AlarmIndex::collectionFetch(const QString &collectionId)
+{
+    GCancellable *cancellable = m_cancellables.value(collectionId);
+    if (!cancellable) {
+        cancellable = g_cancellable_new();
+        m_cancellables.insert(collectionId, cancellable);
+    }
+
+    CollectionFetch *fetch = new CollectionFetch;
+    fetch->self = this;
+    fetch->collectionId = collectionId;
+    fetch->cancellable = G_CANCELLABLE(g_object_ref(cancellable));
+    return fetch;
+}
+
+void AlarmIndex::freeCollectionFetch(CollectionFetch *fetch)
+{
+    g_object_unref(fetch->cancellable);
+    delete fetch;
+}
+
+QHash<QString, GSList*> AlarmIndex::groupSeries(GSList *components)
+{
+    QHash<QString, GSList*> series;
+    for (GSList *l = components; l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        const gchar *uid = 0;
+        e_cal_component_get_uid(comp, &uid);
+        QString key = QString::fromUtf8(uid);
+        series.insert(key, g_slist_prepend(series.value(key), comp));
+    }
+    return series;
+}
+
+void AlarmIndex::onAlarmsListed(GObject *source, GAsyncResult *res, CollectionFetch *fetch)
+{
+    GError *gError = 0;
+    GSList *components = 0;
+    e_cal_client_get_object_list_as_comps_finish(E_CAL_CLIENT(source), res, &components, &gError);
+
+    // the index was invalidated or destroyed while listing
+    if (g_cancellable_is_cancelled(fetch->cancellable)) {
+        if (gError) {
+            g_error_free(gError);
+        }
+        e_cal_client_free_ecalcomp_slist(components);
+        freeCollectionFetch(fetch);
+        return;
+    }
+
+    AlarmIndex *self = fetch->self;
+    if (gError) {
+        qWarning() << "Fail to list alarms (" << fetch->collectionId << "):" << gError->message;
+        g_error_free(gError);
+        self->buildDone(fetch->collectionId);
+        freeCollectionFetch(fetch);
+        return;
+    }
+
+    // the detached occurrences of a series may have no alarm in the window,
+    // recurrent masters are indexed once their whole series is listed
+    QStringList recurrent;
+    for (GSList *l = components; l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        if (!e_cal_component_is_instance(comp) && e_cal_component_has_recurrences(comp)) {
+            const gchar *uid = 0;
+            e_cal_component_get_uid(comp, &uid);
+            recurrent << QString::fromUtf8(uid);
+        }
+    }
+
+    QHash<QString, GSList*> series = groupSeries(components);
+    for (QHash<QString, GSList*>::const_iterator i = series.constBegin(); i != series.constEnd(); ++i) {
+        if (!recurrent.contains(i.key())) {
+            self->indexSeries(fetch->collectionId, E_CAL_CLIENT(source), i.key(), i.value());
+        }
+        g_slist_free(i.value());
+    }
+    e_cal_client_free_ecalcomp_slist(components);
+
+    if (recurrent.isEmpty()) {
+        self->buildDone(fetch->collectionId);
+        freeCollectionFetch(fetch);
+    } else {
+        e_cal_client_get_object_list_as_comps(E_CAL_CLIENT(source),
+                                              SeriesExpansion::seriesQuery(recurrent).toUtf8().constData(),
+                                              fetch->cancellable,
+                                              (GAsyncReadyCallback) AlarmIndex::onSeriesListed,
+                                              fetch);
+    }
+}
+
+void AlarmIndex::onSeriesListed(GObject *source, GAsyncResult *res, CollectionFetch *fetch)
+{
+    GError *gError = 0;
+    GSList *components = 0;
+    e_cal_client_get_object_list_as_comps_finish(E_CAL_CLIENT(source), res, &components, &gError);
+
+    if (g_cancellable_is_cancelled(fetch->cancellable)) {
+        if (gError) {
+            g_error_free(gError);
+        }
+        e_cal_client_free_ecalcomp_slist(components);
+        freeCollectionFetch(fetch);
+        return;
+    }
+
+    AlarmIndex *self = fetch->self;
+    if (gError) {
+        qWarning() << "Fail to list alarm series (" << fetch->collectionId << "):" << gError->message;
+        g_error_free(gError);
+    } else {
+        QHash<QString, GSList*> series = groupSeries(components);
+        for (QHash<QString, GSList*>::const_iterator i = series.constBegin(); i != series.constEnd(); ++i) {
+            self->indexSeries(fetch->collectionId, E_CAL_CLIENT(source), i.key(), i.value());
+            g_slist_free(i.value());
+        }
+        e_cal_client_free_ecalcomp_slist(components);
+    }
+
+    self->buildDone(fetch->collectionId);
+    freeCollectionFetch(fetch);
+}
+
+void AlarmIndex::indexSeries(const QString &collectionId,
+                             ECalClient *client,
+                             const QString &uid,
+                             GSList *components)
+{
+    // occurrences with a detached component get their alarms from it
+    QSet<QString> exceptions;
+    for (GSList *l = components; l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        if (e_cal_component_is_instance(comp)) {
+            exceptions << SeriesExpansion::exceptionKey(client, comp);
+        }
+    }
+
+    Series series;
+    for (GSList *l = components; l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        QList<Trigger> triggers = componentTriggers(collectionId, client, uid, comp, exceptions);
+        if (e_cal_component_is_instance(comp)) {
+            gchar *recurId = e_cal_component_get_recurid_as_string(comp);
+            if (!triggers.isEmpty()) {
+                series.instances.insert(QString::fromUtf8(recurId), triggers);
+            }
+            g_free(recurId);
+        } else {
+            series.master = triggers;
+            series.masterAlarms = e_cal_component_has_recurrences(comp) &&
+                                  e_cal_component_has_alarms(comp);
+        }
+    }
+
+    if (series.master.isEmpty() && series.instances.isEmpty() && !series.masterAlarms) {
+        m_triggers[collectionId].remove(uid);
+    } else {
+        m_triggers[collectionId].insert(uid, series);
+    }
+}
+
+void AlarmIndex::indexComponent(const QString &collectionId,
+                                ECalClient *client,
+                                const QString &uid,
+                                ECalComponent *comp)
+{
+    Series &series = m_triggers[collectionId][uid];
+    QList<Trigger> triggers = componentTriggers(collectionId, client, uid, comp, QSet<QString>());
+    if (e_cal_component_is_instance(comp)) {
+        gchar *recurId = e_cal_component_get_recurid_as_string(comp);
+        QString rid = QString::fromUtf8(recurId);
+        g_free(recurId);
+        if (triggers.isEmpty()) {
+            series.instances.remove(rid);
+        } else {
+            series.instances.insert(rid, triggers);
+        }
+
+        // the detached component replaces the series occurrence
+        QString key = SeriesExpansion::exceptionKey(client, comp);
+        for (int i = series.master.size() - 1; i >= 0; i--) {
+            if (key == QString("%1\n%2").arg(uid).arg(qint64(series.master[i].occurrence))) {
+                series.master.removeAt(i);
+            }
+        }
+    } else {
+        // only used for masters without alarms or without recurrences
+        series.master = triggers;
+        series.masterAlarms = false;
+    }
+
+    if (series.master.isEmpty() && series.instances.isEmpty() && !series.masterAlarms) {
+        m_triggers[collectionId].remove(uid);
+    }
+}
+
+QList<AlarmIndex::Trigger> AlarmIndex::componentTriggers(const QString &collectionId,
+                                                          ECalClient *client,
+                                                          const QString &uid,
+                                                          ECalComponent *comp,
+                                                          const QSet<QString> &exceptions)
+{
+    QList<Trigger> triggers;
+    ECalComponentAlarmAction omit[] = {(ECalComponentAlarmAction) -1};
+    ECalComponentAlarms *alarms = e_cal_util_generate_alarms_for_comp(comp,
+                                                                     m_windowStart,
+                                                                     m_windowEnd,
+                                                                     omit,
+                                                                     e_cal_client_resolve_tzid_cb,
+                                                                     client,
+                                                                     e_cal_client_get_default_timezone(client));
+    if (!alarms) {
+        return triggers;
+    }
+
+    bool isSeries = !e_cal_component_is_instance(comp) && e_cal_component_has_recurrences(comp);
+    QString rid;
+    QByteArray tzId;
+    bool isDate = false;
+    icaltimezone *zone = 0;
+    if (isSeries) {
+        zone = SeriesExpansion::startZone(client, comp, &tzId, &isDate);
+    } else if (e_cal_component_is_instance(comp)) {
+        gchar *recurId = e_cal_component_get_recurid_as_string(comp);
+        rid = QString::fromUtf8(recurId);
+        g_free(recurId);
+    }
+
+    for (GSList *a = alarms->alarms; a; a = a->next) {
+        ECalComponentAlarmInstance *instance = static_cast<ECalComponentAlarmInstance*>(a->data);
+        Trigger trigger;
+        trigger.occurrence = 0;
+        if (isSeries) {
+            if (exceptions.contains(QString("%1\n%2").arg(uid).arg(qint64(instance->occur_start)))) {
+                continue;
+            }
+            struct icaltimetype occurrence = icaltime_from_timet_with_zone(instance->occur_start, isDate, zone);
+            rid = QString::fromUtf8(icaltime_as_ical_string(occurrence));
+            trigger.occurrence = instance->occur_start;
+        }
+
+        trigger.trigger = instance->trigger;
+        trigger.itemId = QOrganizerItemId(new QOrganizerEDSEngineId(collectionId, uid, rid));
+        triggers << trigger;
+    }
+    e_cal_component_alarms_free(alarms);
+    return triggers;
+}
+
+void AlarmIndex::fetchSeries(const QString &collectionId, ECalClient *client, const QString &uid)
+{
+    GCancellable *cancellable = m_cancellables.value(collectionId);
+    if (!cancellable) {
+        cancellable = g_cancellable_new();
+        m_cancellables.insert(collectionId, cancellable);
+    }
+
+    SeriesFetch *fetch = new SeriesFetch;
+    fetch->self = this;
+    fetch->collectionId = collectionId;
+    fetch->uid = uid;
+    fetch->cancellable = G_CANCELLABLE(g_object_ref(cancellable));
+    e_cal_client_get_objects_for_uid(client,
+                                     uid.toUtf8().constData(),
+                                     cancellable,
+                                     (GAsyncReadyCallback) AlarmIndex::onSeriesFetched,
+                                     fetch);
+}
+
+void AlarmIndex::onSeriesFetched(GObject *source, GAsyncResult *res, SeriesFetch *fetch)
+{
+    GError *gError = 0;
+    GSList *components = 0;
+    e_cal_client_get_objects_for_uid_finish(E_CAL_CLIENT(source), res, &components, &gError);
+
+    // the index was invalidated or destroyed while fetching
+    if (g_cancellable_is_cancelled(fetch->cancellable)) {
+        if (gError) {
+            g_error_free(gError);
+        }
+        e_cal_client_free_ecalcomp_slist(components);
+    } else if (gError) {
+        // the series does not exist anymore
+        g_error_free(gError);
+        fetch->self->m_triggers[fetch->collectionId].remove(fetch->uid);
+    } else {
+        fetch->self->indexSeries(fetch->collectionId, E_CAL_CLIENT(source), fetch->uid, components);
+        e_cal_client_free_ecalcomp_slist(components);
+    }
+
+    g_object_unref(fetch->cancellable);
+    delete fetch;
+}
+
+void AlarmIndex::cancelFetches(const QString &collectionId)
+{
+    GCancellable *cancellable = m_cancellables.take(collectionId);
+    if (cancellable) {
+        g_cancellable_cancel(cancellable);
+        g_object_unref(cancellable);
+    }
+    // a canceled listing never reports back
+    if (m_building.contains(collectionId)) {
+        buildDone(collectionId);
+    }
+}
+
+void AlarmIndex::updateComponents(const QString &collectionId, ECalClient *client, GSList *components)
+{
+    if (!m_valid) {
+        return;
+    }
+
+    QHash<QString, QList<icalcomponent*> > series;
+    for (GSList *l = components; l; l = l->next) {
+        icalcomponent *ical = static_cast<icalcomponent*>(l->data);
+        QString uid = QString::fromUtf8(icalcomponent_get_uid(ical));
+        series[uid] << ical;
+    }
+
+    for (QHash<QString, QList<icalcomponent*> >::const_iterator i = series.constBegin();
+         i != series.constEnd(); ++i) {
+        // a recurrent master with alarms needs its exceptions, the other
+        // components are indexed from the view notification alone
+        bool fetch = false;
+        Q_FOREACH(icalcomponent *ical, i.value()) {
+            if (!e_cal_util_component_is_instance(ical) &&
+                e_cal_util_component_has_recurrences(ical) &&
+                icalcomponent_get_first_component(ical, ICAL_VALARM_COMPONENT)) {
+                fetch = true;
+                break;
+            }
+        }
+
+        if (fetch) {
+            fetchSeries(collectionId, client, i.key());
+            continue;
+        }
+
+        Q_FOREACH(icalcomponent *ical, i.value()) {
+            ECalComponent *comp = e_cal_component_new_from_icalcomponent(icalcomponent_new_clone(ical));
+            if (comp) {
+                indexComponent(collectionId, client, i.key(), comp);
+                g_object_unref(comp);
+            }
+        }
+    }
+}
+
+void AlarmIndex::removeComponents(const QString &collectionId, ECalClient *client, GSList *ids)
+{
+    if (!m_valid) {
+        return;
+    }
+
+    QSet<QString> uids;
+    for (GSList *l = ids; l; l = l->next) {
+        ECalComponentId *id = static_cast<ECalComponentId*>(l->data);
+        QString uid = QString::fromUtf8(id->uid);
+        if (!m_triggers.value(collectionId).contains(uid)) {
+            continue;
+        }
+
+        if (id->rid && *id->rid) {
+            Series &series = m_triggers[collectionId][uid];
+            series.instances.remove(QString::fromUtf8(id->rid));
+            if (series.masterAlarms) {
+                // the occurrence may come back from the series
+                uids << uid;
+            } else if (series.master.isEmpty() && series.instances.isEmpty()) {
+                m_triggers[collectionId].remove(uid);
+            }
+        } else {
+            m_triggers[collectionId].remove(uid);
+            uids.remove(uid);
+        }
+    }
+
+    Q_FOREACH(const QString &uid, uids) {
+        fetchSeries(collectionId, client, uid);
+    }
+}
+
+void AlarmIndex::removeCollection(const QString &collectionId)
+{
+    cancelFetches(collectionId);
+    m_triggers.remove(collectionId);
+}
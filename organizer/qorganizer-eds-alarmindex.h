@@ -0,0 +1,123 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_ALARMINDEX_H__
+#define __QORGANIZER_EDS_ALARMINDEX_H__
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QDateTime>
+#include <QEventLoop>
+
+#include <QtOrganizer/QOrganizerItemId>
+
+#include <libecal/libecal.h>
+
+class QOrganizerEDSEngineData;
+
+// Alarm triggers of all collections inside a time window, built on demand and
+// kept up to date by the view watchers
+class AlarmIndex
+{
+public:
+    typedef QPair<QtOrganizer::QOrganizerItemId, QDateTime> Alarm;
+
+    AlarmIndex(QOrganizerEDSEngineData *data);
+    ~AlarmIndex();
+
+    QList<Alarm> alarms(const QDateTime &start, const QDateTime &end);
+    bool isValid() const;
+    void invalidate();
+
+    void updateComponents(const QString &collectionId, ECalClient *client, GSList *components);
+    void removeComponents(const QString &collectionId, ECalClient *client, GSList *ids);
+    void removeCollection(const QString &collectionId);
+
+private:
+    struct Trigger
+    {
+        time_t trigger;
+        // start of the series occurrence, 0 for other components
+        time_t occurrence;
+        QtOrganizer::QOrganizerItemId itemId;
+    };
+
+    struct Series
+    {
+        Series() : masterAlarms(false) {}
+
+        // triggers of the master occurrences without a detached component
+        QList<Trigger> master;
+        // recurrence id -> triggers of the detached component
+        QHash<QString, QList<Trigger> > instances;
+        // recurrent master with alarms, its occurrences depend on the exceptions
+        bool masterAlarms;
+    };
+
+    struct SeriesFetch
+    {
+        AlarmIndex *self;
+        QString collectionId;
+        QString uid;
+        GCancellable *cancellable;
+    };
+
+    struct CollectionFetch
+    {
+        AlarmIndex *self;
+        QString collectionId;
+        GCancellable *cancellable;
+    };
+
+    QOrganizerEDSEngineData *m_data;
+    // collection id -> series uid -> triggers
+    QHash<QString, QHash<QString, Series> > m_triggers;
+    // collection id -> pending series fetches
+    QHash<QString, GCancellable*> m_cancellables;
+    // collections still being listed by build()
+    QSet<QString> m_building;
+    QEventLoop *m_eventLoop;
+    time_t m_windowStart;
+    time_t m_windowEnd;
+    bool m_valid;
+
+    void build(time_t start, time_t end);
+    void buildDone(const QString &collectionId);
+    CollectionFetch *collectionFetch(const QString &collectionId);
+    void indexSeries(const QString &collectionId, ECalClient *client, const QString &uid, GSList *components);
+    void indexComponent(const QString &collectionId, ECalClient *client, const QString &uid, ECalComponent *comp);
+    QList<Trigger> componentTriggers(const QString &collectionId,
+                                     ECalClient *client,
+                                     const QString &uid,
+                                     ECalComponent *comp,
+                                     const QSet<QString> &exceptions);
+    void fetchSeries(const QString &collectionId, ECalClient *client, const QString &uid);
+    void cancelFetches(const QString &collectionId);
+
+    static void onSeriesFetched(GObject *source, GAsyncResult *res, SeriesFetch *fetch);
+    static void onAlarmsListed(GObject *source, GAsyncResult *res, CollectionFetch *fetch);
+    static void onSeriesListed(GObject *source, GAsyncResult *res, CollectionFetch *fetch);
+    static void freeCollectionFetch(CollectionFetch *fetch);
+    static QHash<QString, GSList*> groupSeries(GSList *components);
+
+    Q_DISABLE_COPY(AlarmIndex)
+};
+
+#endif
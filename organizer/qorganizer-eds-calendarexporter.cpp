@@ -0,0 +1,220 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-calendarexporter.h"
+#include "qorganizer-eds-source-registry.h"
+
+#include <QtCore/QDebug>
+
+using namespace QtOrganizer;
+
+CalendarExporter::CalendarExporter(SourceRegistry *registry, QIODevice *device)
+    : m_registry(registry),
+      m_device(device),
+      m_client(0),
+      m_eventLoop(0),
+      m_exportedCount(0),
+      m_failed(false)
+{
+}
+
+CalendarExporter::~CalendarExporter()
+{
+}
+
+int CalendarExporter::exportedCount() const
+{
+    return m_exportedCount;
+}
+
+bool CalendarExporter::exportCollection(const QString &collectionId, QOrganizerManager::Error *error)
+{
+    EClient *client = m_registry->client(collectionId);
+    if (!client) {
+        *error = QOrganizerManager::InvalidCollectionError;
+        return false;
+    }
+
+    m_collectionId = collectionId;
+    m_client = E_CAL_CLIENT(client);
+    m_tzIds.clear();
+    m_failed = false;
+
+    GError *gError = 0;
+    ECalClientView *view = 0;
+    e_cal_client_get_view_sync(E_CAL_CLIENT(client),
+                               "#t", // match all
+                               &view,
+                               0,
+                               &gError);
+    if (gError) {
+        qWarning() << "Fail to open view (" << collectionId << "):" << gError->message;
+        g_error_free(gError);
+        g_object_unref(client);
+        *error = QOrganizerManager::UnspecifiedError;
+        return false;
+    }
+
+    if (!write("BEGIN:VCALENDAR\r\n"
+               "PRODID:-//Canonical Ltd//qtorganizer5-eds//EN\r\n"
+               "VERSION:2.0\r\n")) {
+        g_object_unref(view);
+        g_object_unref(client);
+        *error = QOrganizerManager::UnspecifiedError;
+        return false;
+    }
+
+    gulong addedId = g_signal_connect(view,
+                                      "objects-added",
+                                      (GCallback) CalendarExporter::onObjectsAdded,
+                                      this);
+    gulong completeId = g_signal_connect(view,
+                                         "complete",
+                                         (GCallback) CalendarExporter::onComplete,
+                                         this);
+    e_cal_client_view_set_flags(view, E_CAL_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL, NULL);
+    e_cal_client_view_start(view, &gError);
+    if (gError) {
+        qWarning() << "Fail to start view (" << collectionId << "):" << gError->message;
+        g_error_free(gError);
+        gError = 0;
+        m_failed = true;
+    } else {
+        QEventLoop eventLoop;
+        m_eventLoop = &eventLoop;
+        eventLoop.exec();
+        m_eventLoop = 0;
+
+        e_cal_client_view_stop(view, &gError);
+        if (gError) {
+            qWarning() << "Fail to stop view" << gError->message;
+            g_error_free(gError);
+            gError = 0;
+        }
+    }
+    g_signal_handler_disconnect(view, addedId);
+    g_signal_handler_disconnect(view, completeId);
+    g_object_unref(view);
+
+    if (!m_failed) {
+        m_failed = !write("END:VCALENDAR\r\n");
+    }
+    m_client = 0;
+    g_object_unref(client);
+
+    if (m_failed) {
+        *error = QOrganizerManager::UnspecifiedError;
+        return false;
+    }
+    return true;
+}
+
+bool CalendarExporter::write(const char *data)
+{
+    qint64 size = qstrlen(data);
+    if (m_device->write(data, size) != size) {
+        qWarning() << "Fail to write calendar data:" << m_device->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CalendarExporter::writeTimeZones(icalcomponent *comp)
+{
+    // an importer reading the stream in order must know the timezone
+    // before the components using it
+    for (icalproperty *prop = icalcomponent_get_first_property(comp, ICAL_ANY_PROPERTY);
+         prop;
+         prop = icalcomponent_get_next_property(comp, ICAL_ANY_PROPERTY)) {
+        icalparameter *param = icalproperty_get_first_parameter(prop, ICAL_TZID_PARAMETER);
+        if (!param) {
+            continue;
+        }
+
+        QByteArray tzId(icalparameter_get_tzid(param));
+        if (!m_tzIds.contains(tzId)) {
+            m_tzIds.insert(tzId);
+            if (!writeTimeZone(tzId)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CalendarExporter::writeTimeZone(const QByteArray &tzId)
+{
+    GError *gError = 0;
+    icaltimezone *zone = 0;
+    e_cal_client_get_timezone_sync(m_client, tzId.constData(), &zone, 0, &gError);
+    if (gError) {
+        qWarning() << "Fail to get timezone" << tzId << ":" << gError->message;
+        g_error_free(gError);
+        return true;
+    }
+
+    icalcomponent *vtimezone = zone ? icaltimezone_get_component(zone) : 0;
+    if (vtimezone) {
+        gchar *data = icalcomponent_as_ical_string_r(vtimezone);
+        bool written = write(data);
+        g_free(data);
+        return written;
+    }
+    return true;
+}
+
+void CalendarExporter::onObjectsAdded(ECalClientView *view,
+                                      GSList *objects,
+                                      CalendarExporter *self)
+{
+    Q_UNUSED(view);
+    if (self->m_failed) {
+        return;
+    }
+
+    for (GSList *l = objects; l; l = l->next) {
+        icalcomponent *comp = static_cast<icalcomponent*>(l->data);
+        bool written = self->writeTimeZones(comp);
+        if (written) {
+            gchar *data = icalcomponent_as_ical_string_r(comp);
+            written = self->write(data);
+            g_free(data);
+        }
+        if (!written) {
+            // nothing else can be written, wait for the view to complete
+            self->m_failed = true;
+            return;
+        }
+        self->m_exportedCount++;
+    }
+    Q_EMIT self->progress(self->m_collectionId, self->m_exportedCount);
+}
+
+void CalendarExporter::onComplete(ECalClientView *view,
+                                  const GError *error,
+                                  CalendarExporter *self)
+{
+    Q_UNUSED(view);
+    if (error) {
+        qWarning() << "Fail to list objects (" << self->m_collectionId << "):" << error->message;
+        self->m_failed = true;
+    }
+    if (self->m_eventLoop) {
+        self->m_eventLoop->quit();
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_CALENDAREXPORTER_H__
+#define __QORGANIZER_EDS_CALENDAREXPORTER_H__
+
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QByteArray>
+#include <QtCore/QEventLoop>
+#include <QtCore/QIODevice>
+
+#include <QtOrganizer/QOrganizerManager>
+
+#include <libecal/libecal.h>
+
+class SourceRegistry;
+
+// Writes the raw iCalendar data of the collections to a device, one
+// VCALENDAR per collection; components are written as the view reports
+// them so only one batch is kept in memory, each timezone is written
+// before the first component using it
+class CalendarExporter : public QObject
+{
+    Q_OBJECT
+public:
+    CalendarExporter(SourceRegistry *registry, QIODevice *device);
+    ~CalendarExporter();
+
+    bool exportCollection(const QString &collectionId, QtOrganizer::QOrganizerManager::Error *error);
+    int exportedCount() const;
+
+Q_SIGNALS:
+    void progress(const QString &collectionId, int exportedCount);
+
+private:
+    SourceRegistry *m_registry;
+    QIODevice *m_device;
+    QString m_collectionId;
+    ECalClient *m_client;
+    QSet<QByteArray> m_tzIds;
+    QEventLoop *m_eventLoop;
+    int m_exportedCount;
+    bool m_failed;
+
+    bool write(const char *data);
+    bool writeTimeZones(icalcomponent *comp);
+    bool writeTimeZone(const QByteArray &tzId);
+
+    static void onObjectsAdded(ECalClientView *view, GSList *objects, CalendarExporter *self);
+    static void onComplete(ECalClientView *view, const GError *error, CalendarExporter *self);
+
+    Q_DISABLE_COPY(CalendarExporter)
+};
+
+#endif
@@ -0,0 +1,352 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-calendarimporter.h"
+
+#include <QtCore/QDebug>
+
+// number of components sent to the server in a single call
+#define IMPORT_CHUNK_SIZE           100
+// number of create calls waiting for an answer
+#define IMPORT_MAX_PENDING_CHUNKS   3
+
+using namespace QtOrganizer;
+
+CalendarImporter::CalendarImporter(ECalClient *client, QIODevice *device)
+    : m_client(client),
+      m_device(device),
+      m_kind(ICAL_VEVENT_COMPONENT),
+      m_eventLoop(0),
+      m_depth(0),
+      m_index(0),
+      m_pending(0),
+      m_importedCount(0),
+      m_atEnd(false)
+{
+    if (m_client) {
+        switch (e_cal_client_get_source_type(m_client)) {
+        case E_CAL_CLIENT_SOURCE_TYPE_TASKS:
+            m_kind = ICAL_VTODO_COMPONENT;
+            break;
+        case E_CAL_CLIENT_SOURCE_TYPE_MEMOS:
+            m_kind = ICAL_VJOURNAL_COMPONENT;
+            break;
+        default:
+            m_kind = ICAL_VEVENT_COMPONENT;
+            break;
+        }
+    }
+}
+
+CalendarImporter::~CalendarImporter()
+{
+    while (!m_retry.isEmpty()) {
+        freeChunk(m_retry.dequeue());
+    }
+    releaseWaiting();
+    Q_FOREACH(icalcomponent *comp, m_exceptions.components) {
+        icalcomponent_free(comp);
+    }
+}
+
+int CalendarImporter::importedCount() const
+{
+    return m_importedCount;
+}
+
+bool CalendarImporter::importItems(QMap<int, QOrganizerManager::Error> *errorMap)
+{
+    QEventLoop eventLoop;
+    m_eventLoop = &eventLoop;
+    fill();
+    if (m_pending > 0) {
+        eventLoop.exec();
+    }
+    m_eventLoop = 0;
+
+    if (errorMap) {
+        *errorMap = m_errors;
+    }
+    return m_errors.isEmpty();
+}
+
+QByteArray CalendarImporter::readComponent()
+{
+    // the text of the components inside the VCALENDAR is kept as it is,
+    // folded lines start with a space so they are never taken as BEGIN/END
+    QByteArray component;
+    while (!m_device->atEnd()) {
+        QByteArray line = m_device->readLine();
+        if (qstrnicmp(line.constData(), "BEGIN:", 6) == 0) {
+            m_depth++;
+        }
+        if (m_depth >= 2) {
+            component += line;
+        }
+        if (qstrnicmp(line.constData(), "END:", 4) == 0) {
+            m_depth = qMax(m_depth - 1, 0);
+            if ((m_depth == 1) && !component.isEmpty()) {
+                return component;
+            }
+        }
+    }
+    return QByteArray();
+}
+
+CalendarImporter::Chunk *CalendarImporter::nextChunk()
+{
+    Chunk *chunk = 0;
+    while (!chunk || (chunk->indexes.size() < IMPORT_CHUNK_SIZE)) {
+        QByteArray data = readComponent();
+        if (data.isEmpty()) {
+            m_atEnd = true;
+            break;
+        }
+
+        icalcomponent *comp = icalparser_parse_string(data.constData());
+        if (comp && (icalcomponent_isa(comp) == ICAL_VTIMEZONE_COMPONENT)) {
+            addTimeZone(comp);
+            icalcomponent_free(comp);
+            continue;
+        }
+
+        int index = m_index++;
+        if (!comp || (icalcomponent_count_errors(comp) > 0)) {
+            m_errors.insert(index, QOrganizerManager::BadArgumentError);
+        } else if (icalcomponent_isa(comp) != m_kind) {
+            m_errors.insert(index, QOrganizerManager::InvalidItemTypeError);
+        } else if (icalcomponent_get_first_property(comp, ICAL_RECURRENCEID_PROPERTY)) {
+            // the series may still be in flight, or later in the stream
+            QString uid = QString::fromUtf8(icalcomponent_get_uid(comp));
+            Exceptions &exceptions = m_createdUids.contains(uid) ? m_exceptions : m_waiting[uid];
+            exceptions.indexes << index;
+            exceptions.components << comp;
+            continue;
+        } else {
+            if (!chunk) {
+                chunk = new Chunk;
+                chunk->self = this;
+                chunk->components = 0;
+                chunk->exceptions = false;
+            }
+            chunk->indexes << index;
+            chunk->components = g_slist_prepend(chunk->components, comp);
+            continue;
+        }
+
+        if (comp) {
+            icalcomponent_free(comp);
+        }
+    }
+
+    if (chunk) {
+        chunk->components = g_slist_reverse(chunk->components);
+    }
+    return chunk;
+}
+
+CalendarImporter::Chunk *CalendarImporter::nextExceptionsChunk()
+{
+    Chunk *chunk = new Chunk;
+    chunk->self = this;
+    chunk->components = 0;
+    chunk->exceptions = true;
+
+    int count = qMin(m_exceptions.components.size(), IMPORT_CHUNK_SIZE);
+    chunk->indexes = m_exceptions.indexes.mid(0, count);
+    for(int i = count - 1; i >= 0; i--) {
+        chunk->components = g_slist_prepend(chunk->components, m_exceptions.components[i]);
+    }
+    m_exceptions.indexes = m_exceptions.indexes.mid(count);
+    m_exceptions.components = m_exceptions.components.mid(count);
+    return chunk;
+}
+
+void CalendarImporter::fill()
+{
+    while (m_pending < IMPORT_MAX_PENDING_CHUNKS) {
+        Chunk *chunk = 0;
+        if (!m_retry.isEmpty()) {
+            chunk = m_retry.dequeue();
+        } else if (!m_exceptions.components.isEmpty()) {
+            chunk = nextExceptionsChunk();
+        } else if (!m_atEnd) {
+            chunk = nextChunk();
+            if (!chunk) {
+                // the last components read may be detached occurrences
+                continue;
+            }
+        } else if ((m_pending == 0) && !m_waiting.isEmpty()) {
+            // every series is done, the server decides about the rest
+            releaseWaiting();
+            continue;
+        }
+        if (!chunk) {
+            break;
+        }
+
+        m_pending++;
+        if (chunk->exceptions) {
+            icalcomponent *vcalendar = e_cal_util_new_top_level();
+            icalcomponent_set_method(vcalendar, ICAL_METHOD_PUBLISH);
+            for (GSList *l = chunk->components; l; l = l->next) {
+                icalcomponent_add_component(vcalendar,
+                                            icalcomponent_new_clone(static_cast<icalcomponent*>(l->data)));
+            }
+            e_cal_client_receive_objects(m_client,
+                                         vcalendar,
+                                         0,
+                                         (GAsyncReadyCallback) CalendarImporter::onObjectsReceived,
+                                         chunk);
+            icalcomponent_free(vcalendar);
+        } else {
+            e_cal_client_create_objects(m_client,
+                                        chunk->components,
+                                        0,
+                                        (GAsyncReadyCallback) CalendarImporter::onObjectsCreated,
+                                        chunk);
+        }
+    }
+
+    if ((m_pending == 0) && m_eventLoop) {
+        m_eventLoop->quit();
+    }
+}
+
+void CalendarImporter::retry(Chunk *chunk)
+{
+    // the server rejects the whole chunk, send the components one by one to
+    // find out which ones fail
+    int i = 0;
+    for (GSList *l = chunk->components; l; l = l->next, i++) {
+        Chunk *single = new Chunk;
+        single->self = this;
+        single->exceptions = chunk->exceptions;
+        single->indexes << chunk->indexes[i];
+        single->components = g_slist_append(0, l->data);
+        m_retry.enqueue(single);
+    }
+    g_slist_free(chunk->components);
+    delete chunk;
+}
+
+void CalendarImporter::seriesCreated(Chunk *chunk)
+{
+    for (GSList *l = chunk->components; l; l = l->next) {
+        QString uid = QString::fromUtf8(icalcomponent_get_uid(static_cast<icalcomponent*>(l->data)));
+        m_createdUids.insert(uid);
+        if (m_waiting.contains(uid)) {
+            Exceptions waiting = m_waiting.take(uid);
+            m_exceptions.indexes += waiting.indexes;
+            m_exceptions.components += waiting.components;
+        }
+    }
+}
+
+void CalendarImporter::releaseWaiting()
+{
+    Q_FOREACH(const Exceptions &waiting, m_waiting) {
+        m_exceptions.indexes += waiting.indexes;
+        m_exceptions.components += waiting.components;
+    }
+    m_waiting.clear();
+}
+
+void CalendarImporter::addTimeZone(icalcomponent *vtimezone)
+{
+    icaltimezone *zone = icaltimezone_new();
+    icaltimezone_set_component(zone, icalcomponent_new_clone(vtimezone));
+
+    GError *gError = 0;
+    e_cal_client_add_timezone_sync(m_client, zone, 0, &gError);
+    if (gError) {
+        qWarning() << "Fail to add timezone:" << gError->message;
+        g_error_free(gError);
+    }
+    icaltimezone_free(zone, 1);
+}
+
+void CalendarImporter::freeChunk(Chunk *chunk)
+{
+    g_slist_free_full(chunk->components, (GDestroyNotify) icalcomponent_free);
+    delete chunk;
+}
+
+QOrganizerManager::Error CalendarImporter::parseError(const GError *error)
+{
+    if (g_error_matches(error, E_CAL_CLIENT_ERROR, E_CAL_CLIENT_ERROR_OBJECT_ID_ALREADY_EXISTS)) {
+        return QOrganizerManager::AlreadyExistsError;
+    }
+    return QOrganizerManager::UnspecifiedError;
+}
+
+void CalendarImporter::onObjectsCreated(GObject *source, GAsyncResult *res, Chunk *chunk)
+{
+    CalendarImporter *self = chunk->self;
+    GError *gError = 0;
+    GSList *uids = 0;
+    e_cal_client_create_objects_finish(E_CAL_CLIENT(source), res, &uids, &gError);
+    self->m_pending--;
+
+    if (gError) {
+        if (chunk->indexes.size() > 1) {
+            self->retry(chunk);
+            chunk = 0;
+        } else {
+            qWarning() << "Fail to import item" << chunk->indexes.first() << ":" << gError->message;
+            self->m_errors.insert(chunk->indexes.first(), parseError(gError));
+        }
+        g_error_free(gError);
+    } else {
+        self->m_importedCount += chunk->indexes.size();
+        g_slist_free_full(uids, g_free);
+    }
+
+    if (chunk) {
+        // even if the series failed, the server decides about its exceptions
+        self->seriesCreated(chunk);
+        freeChunk(chunk);
+    }
+    self->fill();
+}
+
+void CalendarImporter::onObjectsReceived(GObject *source, GAsyncResult *res, Chunk *chunk)
+{
+    CalendarImporter *self = chunk->self;
+    GError *gError = 0;
+    e_cal_client_receive_objects_finish(E_CAL_CLIENT(source), res, &gError);
+    self->m_pending--;
+
+    if (gError) {
+        if (chunk->indexes.size() > 1) {
+            self->retry(chunk);
+            chunk = 0;
+        } else {
+            qWarning() << "Fail to import item" << chunk->indexes.first() << ":" << gError->message;
+            self->m_errors.insert(chunk->indexes.first(), parseError(gError));
+        }
+        g_error_free(gError);
+    } else {
+        self->m_importedCount += chunk->indexes.size();
+    }
+
+    if (chunk) {
+        freeChunk(chunk);
+    }
+    self->fill();
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_CALENDARIMPORTER_H__
+#define __QORGANIZER_EDS_CALENDARIMPORTER_H__
+
+#include <QtCore/QMap>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QList>
+#include <QtCore/QQueue>
+#include <QtCore/QByteArray>
+#include <QtCore/QEventLoop>
+#include <QtCore/QIODevice>
+
+#include <QtOrganizer/QOrganizerManager>
+
+#include <libecal/libecal.h>
+
+// Creates the components of an iCalendar stream in a calendar without
+// converting them to organizer items; the stream is read one component at a
+// time and sent to the server in chunks, with a few chunks in flight.
+// Detached occurrences are sent once the chunk creating their series is done.
+// Errors are reported by component index, timezones are not counted.
+class CalendarImporter
+{
+public:
+    CalendarImporter(ECalClient *client, QIODevice *device);
+    ~CalendarImporter();
+
+    bool importItems(QMap<int, QtOrganizer::QOrganizerManager::Error> *errorMap);
+    int importedCount() const;
+
+private:
+    struct Chunk
+    {
+        CalendarImporter *self;
+        QList<int> indexes;
+        GSList *components;
+        // detached occurrences, received instead of created
+        bool exceptions;
+    };
+
+    struct Exceptions
+    {
+        QList<int> indexes;
+        QList<icalcomponent*> components;
+    };
+
+    ECalClient *m_client;
+    QIODevice *m_device;
+    icalcomponent_kind m_kind;
+    QEventLoop *m_eventLoop;
+    int m_depth;
+    int m_index;
+    int m_pending;
+    int m_importedCount;
+    bool m_atEnd;
+    QQueue<Chunk*> m_retry;
+    // detached occurrences whose series is already created
+    Exceptions m_exceptions;
+    // uid -> detached occurrences whose series is not created yet
+    QHash<QString, Exceptions> m_waiting;
+    QSet<QString> m_createdUids;
+    QMap<int, QtOrganizer::QOrganizerManager::Error> m_errors;
+
+    QByteArray readComponent();
+    Chunk *nextChunk();
+    Chunk *nextExceptionsChunk();
+    void fill();
+    void retry(Chunk *chunk);
+    void seriesCreated(Chunk *chunk);
+    void releaseWaiting();
+    void addTimeZone(icalcomponent *vtimezone);
+
+    static void freeChunk(Chunk *chunk);
+    static QtOrganizer::QOrganizerManager::Error parseError(const GError *error);
+    static void onObjectsCreated(GObject *source, GAsyncResult *res, Chunk *chunk);
+    static void onObjectsReceived(GObject *source, GAsyncResult *res, Chunk *chunk);
+
+    Q_DISABLE_COPY(CalendarImporter)
+};
+
+#endif
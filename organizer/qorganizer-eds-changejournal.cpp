@@ -0,0 +1,146 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-changejournal.h"
+
+using namespace QtOrganizer;
+
+// older changes are dropped, asking for them requires a full fetch
+#define CHANGE_JOURNAL_MAX_CHANGES  2048
+
+ChangeJournal::ChangeJournal()
+{
+}
+
+void ChangeJournal::reset(const QString &collectionId, const QString &revision)
+{
+    Journal &journal = m_journals[collectionId];
+    journal.first = 0;
+    journal.changes.clear();
+    journal.marks.clear();
+    journal.lastRevision.clear();
+    mark(&journal, revision);
+}
+
+void ChangeJournal::record(const QString &collectionId,
+                           const QString &revision,
+                           QOrganizerManager::Operation operation,
+                           const QList<QOrganizerItemId> &itemIds)
+{
+    QHash<QString, Journal>::iterator it = m_journals.find(collectionId);
+    if (it == m_journals.end()) {
+        return;
+    }
+
+    mark(&it.value(), revision);
+    Q_FOREACH(const QOrganizerItemId &itemId, itemIds) {
+        it.value().changes << qMakePair(operation, itemId);
+    }
+    if (it.value().changes.size() > CHANGE_JOURNAL_MAX_CHANGES) {
+        truncate(&it.value());
+    }
+}
+
+void ChangeJournal::removeCollection(const QString &collectionId)
+{
+    m_journals.remove(collectionId);
+}
+
+bool ChangeJournal::changesSince(const QString &collectionId,
+                                 const QString &revision,
+                                 const QString &currentRevision,
+                                 QList<QOrganizerItemId> *addedIds,
+                                 QList<QOrganizerItemId> *changedIds,
+                                 QList<QOrganizerItemId> *removedIds)
+{
+    QHash<QString, Journal>::iterator it = m_journals.find(collectionId);
+    if (it == m_journals.end()) {
+        return false;
+    }
+
+    Journal &journal = it.value();
+    mark(&journal, currentRevision);
+    if (revision.isEmpty() || !journal.marks.contains(revision)) {
+        return false;
+    }
+
+    // keep the last operation of each item, an item added and then
+    // changed is still new for the caller
+    QList<QOrganizerItemId> order;
+    QHash<QOrganizerItemId, QOrganizerManager::Operation> operations;
+    for(int i = journal.marks.value(revision) - journal.first; i < journal.changes.size(); i++) {
+        const Change &change = journal.changes.at(i);
+        QHash<QOrganizerItemId, QOrganizerManager::Operation>::iterator op = operations.find(change.second);
+        if (op == operations.end()) {
+            operations.insert(change.second, change.first);
+            order << change.second;
+        } else if ((op.value() == QOrganizerManager::Add) && (change.first == QOrganizerManager::Change)) {
+            continue;
+        } else if ((op.value() == QOrganizerManager::Remove) && (change.first == QOrganizerManager::Add)) {
+            op.value() = QOrganizerManager::Change;
+        } else {
+            op.value() = change.first;
+        }
+    }
+
+    Q_FOREACH(const QOrganizerItemId &itemId, order) {
+        switch (operations.value(itemId)) {
+        case QOrganizerManager::Add:
+            *addedIds << itemId;
+            break;
+        case QOrganizerManager::Change:
+            *changedIds << itemId;
+            break;
+        case QOrganizerManager::Remove:
+            *removedIds << itemId;
+            break;
+        }
+    }
+    return true;
+}
+
+void ChangeJournal::mark(Journal *journal, const QString &revision)
+{
+    if (revision.isEmpty() || (revision == journal->lastRevision)) {
+        return;
+    }
+
+    // a revision seen twice keeps its first position, which can only
+    // report more changes than needed
+    if (!journal->marks.contains(revision)) {
+        journal->marks.insert(revision, journal->first + journal->changes.size());
+    }
+    journal->lastRevision = revision;
+}
+
+void ChangeJournal::truncate(Journal *journal)
+{
+    int dropped = journal->changes.size() / 2;
+    journal->changes.erase(journal->changes.begin(), journal->changes.begin() + dropped);
+    journal->first += dropped;
+
+    // revisions older than the first change kept are no longer known
+    QHash<QString, quint64>::iterator it = journal->marks.begin();
+    while (it != journal->marks.end()) {
+        if (it.value() < journal->first) {
+            it = journal->marks.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
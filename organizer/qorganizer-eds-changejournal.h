@@ -0,0 +1,73 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_CHANGEJOURNAL_H__
+#define __QORGANIZER_EDS_CHANGEJOURNAL_H__
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include <QtOrganizer/QOrganizerItemId>
+#include <QtOrganizer/QOrganizerManager>
+
+// Item changes of each collection tagged with the backend revision seen
+// when they were recorded, kept up to date by the view watchers.
+// A change may be reported again for the next revision, but never missed.
+class ChangeJournal
+{
+public:
+    ChangeJournal();
+
+    void reset(const QString &collectionId, const QString &revision);
+    void record(const QString &collectionId,
+                const QString &revision,
+                QtOrganizer::QOrganizerManager::Operation operation,
+                const QList<QtOrganizer::QOrganizerItemId> &itemIds);
+    void removeCollection(const QString &collectionId);
+
+    bool changesSince(const QString &collectionId,
+                      const QString &revision,
+                      const QString &currentRevision,
+                      QList<QtOrganizer::QOrganizerItemId> *addedIds,
+                      QList<QtOrganizer::QOrganizerItemId> *changedIds,
+                      QList<QtOrganizer::QOrganizerItemId> *removedIds);
+
+private:
+    typedef QPair<QtOrganizer::QOrganizerManager::Operation, QtOrganizer::QOrganizerItemId> Change;
+
+    struct Journal
+    {
+        // sequence number of the first change kept
+        quint64 first;
+        QList<Change> changes;
+        // revision -> sequence number of the first change recorded after it
+        QHash<QString, quint64> marks;
+        QString lastRevision;
+    };
+
+    QHash<QString, Journal> m_journals;
+
+    static void mark(Journal *journal, const QString &revision);
+    static void truncate(Journal *journal);
+
+    Q_DISABLE_COPY(ChangeJournal)
+};
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "qorganizer-eds-collection-engineid.h"
 #include "qorganizer-eds-engineid.h"
+#include "qorganizer-eds-stringpool.h"
 
 #include <QtCore/QDebug>
 
@@ -25,7 +26,7 @@ QOrganizerEDSCollectionEngineId::QOrganizerEDSCollectionEngineId(ESource *source
     : m_esource(source)
 {
     g_object_ref(m_esource);
-    m_collectionId = QString::fromUtf8(e_source_get_uid(m_esource));
+    m_collectionId = StringPool::instance()->intern(e_source_get_uid(m_esource));
     if (e_source_has_extension(m_esource, E_SOURCE_EXTENSION_CALENDAR)) {
         m_sourceType = E_CAL_CLIENT_SOURCE_TYPE_EVENTS;
     } else if (e_source_has_extension(m_esource, E_SOURCE_EXTENSION_TASK_LIST)) {
@@ -60,7 +61,7 @@ QOrganizerEDSCollectionEngineId::QOrganizerEDSCollectionEngineId(const QString&
       m_esource(0)
 {
     // separate engine id part, if full id given
-    m_collectionId = idString.contains(":") ? idString.mid(idString.lastIndexOf(":")+1) : idString;
+    m_collectionId = StringPool::instance()->intern(idString.contains(":") ? idString.mid(idString.lastIndexOf(":")+1) : idString);
 }
 
 QOrganizerEDSCollectionEngineId::~QOrganizerEDSCollectionEngineId()
@@ -53,6 +53,7 @@ private:
     ECalClientSourceType m_sourceType;
 
     friend class SourceRegistry;
+    friend class QOrganizerEDSEngineId;
     //friend class ViewWatcher;
     friend class QOrganizerEDSEngine;
 };
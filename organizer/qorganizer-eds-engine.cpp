@@ -28,13 +28,24 @@
 #include "qorganizer-eds-removebyidrequestdata.h"
 #include "qorganizer-eds-savecollectionrequestdata.h"
 #include "qorganizer-eds-removecollectionrequestdata.h"
+#include "qorganizer-eds-timezonecache.h"
+#include "qorganizer-eds-stringpool.h"
+#include "qorganizer-eds-recurrencecache.h"
+#include "qorganizer-eds-seriesexpansion.h"
+#include "qorganizer-eds-alarmindex.h"
+#include "qorganizer-eds-changejournal.h"
+#include "qorganizer-eds-freebusy.h"
+#include "qorganizer-eds-calendarexporter.h"
+#include "qorganizer-eds-calendarimporter.h"
 #include "qorganizer-eds-viewwatcher.h"
 #include "qorganizer-eds-enginedata.h"
 #include "qorganizer-eds-source-registry.h"
 #include "qorganizer-eds-parseeventthread.h"
+#include "qorganizer-eds-metrics.h"
 
 #include <QtCore/qdebug.h>
 #include <QtCore/QPointer>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTimeZone>
 
 #include <QtOrganizer/QOrganizerEventAttendee>
@@ -72,10 +83,10 @@ QOrganizerEDSEngineData *QOrganizerEDSEngine::m_globalData = 0;
 
 QOrganizerEDSEngine* QOrganizerEDSEngine::createEDSEngine(const QMap<QString, QString>& parameters)
 {
-    Q_UNUSED(parameters);
     if (!m_globalData) {
         m_globalData = new QOrganizerEDSEngineData();
         m_globalData->m_sourceRegistry = new SourceRegistry;
+        m_globalData->m_sourceRegistry->setCacheFile(parameters.value(WARM_START_CACHE_PARAMETER));
     }
     m_globalData->m_refCount.ref();
     return new QOrganizerEDSEngine(m_globalData);
@@ -92,11 +103,17 @@ QOrganizerEDSEngine::QOrganizerEDSEngine(QOrganizerEDSEngineData *data)
     connect(d->m_sourceRegistry, SIGNAL(sourceAdded(QString)), SLOT(onSourceAdded(QString)));
     connect(d->m_sourceRegistry, SIGNAL(sourceRemoved(QString)), SLOT(onSourceRemoved(QString)));
     connect(d->m_sourceRegistry, SIGNAL(sourceUpdated(QString)), SLOT(onSourceUpdated(QString)));
+    connect(d->m_sourceRegistry, SIGNAL(loaded()), SLOT(onSourceRegistryLoaded()));
     d->m_sourceRegistry->load();
 }
 
 QOrganizerEDSEngine::~QOrganizerEDSEngine()
 {
+    Q_FOREACH(QOrganizerAbstractRequest *req, m_pendingRequests) {
+        updateRequestState(req, QOrganizerAbstractRequest::CanceledState);
+    }
+    m_pendingRequests.clear();
+
     while(m_runningRequests.count()) {
         QOrganizerAbstractRequest *req = m_runningRequests.keys().first();
         req->cancel();
@@ -146,11 +163,21 @@ void QOrganizerEDSEngine::itemsAsyncStart(FetchRequestData *data)
 
     QString collection = data->nextCollection();
     if (!collection.isEmpty()) {
+        data->beginPhase(RequestStats::ClientConnect);
         EClient *client = data->parent()->d->m_sourceRegistry->client(collection);
+        data->endPhase(RequestStats::ClientConnect);
         data->setClient(client);
         g_object_unref(client);
 
-        if (data->hasDateInterval()) {
+        data->beginPhase(RequestStats::DBusCall);
+        if (data->hasDateInterval() && data->isLocalExpansion()) {
+            // fetch masters and exceptions once and expand the recurrences in-process
+            e_cal_client_get_object_list_as_comps(E_CAL_CLIENT(client),
+                                                  data->dateFilter().toUtf8().data(),
+                                                  data->cancellable(),
+                                                  (GAsyncReadyCallback) QOrganizerEDSEngine::itemsAsyncExpandListed,
+                                                  data);
+        } else if (data->hasDateInterval()) {
             e_cal_client_generate_instances(data->client(),
                                             data->startDate(),
                                             data->endDate(),
@@ -158,6 +185,13 @@ void QOrganizerEDSEngine::itemsAsyncStart(FetchRequestData *data)
                                             (ECalRecurInstanceFn) QOrganizerEDSEngine::itemsAsyncListed,
                                             data,
                                             (GDestroyNotify) QOrganizerEDSEngine::itemsAsyncDone);
+        } else if (data->isSummaryFetch()) {
+            // use a view to be able to ask only for the fields necessary for the fetch hint
+            e_cal_client_get_view(data->client(),
+                                  data->dateFilter().toUtf8().data(),
+                                  data->cancellable(),
+                                  (GAsyncReadyCallback) QOrganizerEDSEngine::itemsAsyncViewReady,
+                                  data);
         } else {
             // if no date interval was set we return only the main events without recurrence
             e_cal_client_get_object_list_as_comps(E_CAL_CLIENT(client),
@@ -173,7 +207,9 @@ void QOrganizerEDSEngine::itemsAsyncStart(FetchRequestData *data)
 
 void QOrganizerEDSEngine::itemsAsyncDone(FetchRequestData *data)
 {
+    data->endPhase(RequestStats::DBusCall);
     if (data->isLive()) {
+        data->beginPhase(RequestStats::DetachedInstances);
         data->compileCurrentIds();
         itemsAsyncFetchDeatachedItems(data);
     } else {
@@ -191,6 +227,7 @@ void QOrganizerEDSEngine::itemsAsyncFetchDeatachedItems(FetchRequestData *data)
                                          (GAsyncReadyCallback) QOrganizerEDSEngine::itemsAsyncListByIdListed,
                                          data);
     } else {
+        data->endPhase(RequestStats::DetachedInstances);
         itemsAsyncStart(data);
     }
 }
@@ -236,7 +273,12 @@ gboolean QOrganizerEDSEngine::itemsAsyncListed(ECalComponent *comp,
     Q_UNUSED(instanceEnd);
 
     if (data->isLive()) {
-        icalcomponent *icalComp = icalcomponent_new_clone(e_cal_component_get_icalcomponent(comp));
+        icalcomponent *icalComp;
+        if (data->isSummaryFetch()) {
+            icalComp = data->summaryComponent(e_cal_component_get_icalcomponent(comp));
+        } else {
+            icalComp = icalcomponent_new_clone(e_cal_component_get_icalcomponent(comp));
+        }
         if (icalComp) {
             data->appendResult(icalComp);
         }
@@ -256,6 +298,7 @@ void QOrganizerEDSEngine::itemsAsyncListedAsComps(GObject *source,
                                                  res,
                                                  &events,
                                                  &gError);
+    data->endPhase(RequestStats::DBusCall);
     if (gError) {
         qWarning() << "Fail to list events in calendar" << gError->message;
         g_error_free(gError);
@@ -272,11 +315,231 @@ void QOrganizerEDSEngine::itemsAsyncListedAsComps(GObject *source,
     if (data->isLive()) {
         QOrganizerItemFetchRequest *req = data->request<QOrganizerItemFetchRequest>();
         if (req) {
-            data->appendResults(data->parent()->parseEvents(data->collection(),
-                                                            events,
-                                                            false,
-                                                            req->fetchHint().detailTypesHint()));
+            data->beginPhase(RequestStats::Parse);
+            QList<QOrganizerItem> items = data->parent()->parseEvents(data->collection(),
+                                                                      events,
+                                                                      false,
+                                                                      req->fetchHint().detailTypesHint());
+            data->endPhase(RequestStats::Parse);
+            data->appendResults(items);
+        }
+        e_cal_client_free_ecalcomp_slist(events);
+        itemsAsyncStart(data);
+    } else {
+        e_cal_client_free_ecalcomp_slist(events);
+        releaseRequestData(data);
+    }
+}
+
+void QOrganizerEDSEngine::itemsAsyncExpandListed(GObject *source,
+                                                 GAsyncResult *res,
+                                                 FetchRequestData *data)
+{
+    Q_UNUSED(source);
+    GError *gError = 0;
+    GSList *events = 0;
+    e_cal_client_get_object_list_as_comps_finish(E_CAL_CLIENT(data->client()),
+                                                 res,
+                                                 &events,
+                                                 &gError);
+    data->endPhase(RequestStats::DBusCall);
+    if (gError) {
+        qWarning() << "Fail to list events in calendar" << gError->message;
+        g_error_free(gError);
+        gError = 0;
+        if (data->isLive()) {
+            data->finish(QOrganizerManager::InvalidCollectionError);
+        } else {
+            releaseRequestData(data);
+        }
+        return;
+    }
+
+    // check if request was destroyed by the caller
+    if (!data->isLive()) {
+        e_cal_client_free_ecalcomp_slist(events);
+        releaseRequestData(data);
+        return;
+    }
+
+    ECalClient *client = E_CAL_CLIENT(data->client());
+    QStringList series;
+    for (GSList *l = events; l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        if (hasRecurrence(comp)) {
+            data->appendExpansionException(SeriesExpansion::exceptionKey(client, comp));
+        } else if (e_cal_component_has_recurrences(comp)) {
+            const gchar *uid = 0;
+            e_cal_component_get_uid(comp, &uid);
+            series << QString::fromUtf8(uid);
+        }
+    }
+    data->setExpansionComponents(events);
+
+    if (series.isEmpty()) {
+        itemsAsyncExpand(data);
+        return;
+    }
+
+    // an exception moved out of the interval is not listed but still replaces
+    // its occurrence inside it, the exceptions of each series are fetched without range
+    data->beginPhase(RequestStats::DetachedInstances);
+    e_cal_client_get_object_list_as_comps(client,
+                                          SeriesExpansion::seriesQuery(series).toUtf8().data(),
+                                          data->cancellable(),
+                                          (GAsyncReadyCallback) QOrganizerEDSEngine::itemsAsyncExpandExceptionsListed,
+                                          data);
+}
+
+void QOrganizerEDSEngine::itemsAsyncExpandExceptionsListed(GObject *source,
+                                                           GAsyncResult *res,
+                                                           FetchRequestData *data)
+{
+    Q_UNUSED(source);
+    GError *gError = 0;
+    GSList *events = 0;
+    e_cal_client_get_object_list_as_comps_finish(E_CAL_CLIENT(data->client()),
+                                                 res,
+                                                 &events,
+                                                 &gError);
+    data->endPhase(RequestStats::DetachedInstances);
+    if (gError) {
+        qWarning() << "Fail to list deatached events in calendar" << gError->message;
+        g_error_free(gError);
+        gError = 0;
+        if (data->isLive()) {
+            data->finish(QOrganizerManager::InvalidCollectionError);
+        } else {
+            releaseRequestData(data);
         }
+        return;
+    }
+
+    // check if request was destroyed by the caller
+    if (!data->isLive()) {
+        e_cal_client_free_ecalcomp_slist(events);
+        releaseRequestData(data);
+        return;
+    }
+
+    ECalClient *client = E_CAL_CLIENT(data->client());
+    for (GSList *l = events; l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        if (hasRecurrence(comp)) {
+            data->appendExpansionException(SeriesExpansion::exceptionKey(client, comp));
+        }
+    }
+    e_cal_client_free_ecalcomp_slist(events);
+    itemsAsyncExpand(data);
+}
+
+void QOrganizerEDSEngine::itemsAsyncExpand(FetchRequestData *data)
+{
+    ECalClient *client = E_CAL_CLIENT(data->client());
+    time_t startDate = data->startDate();
+    time_t endDate = data->endDate();
+
+    // detached occurrences replace the expanded ones
+    for (GSList *l = data->expansionComponents(); l; l = l->next) {
+        ECalComponent *comp = E_CAL_COMPONENT(l->data);
+        if (!hasRecurrence(comp) && e_cal_component_has_recurrences(comp)) {
+            data->appendExpansion(SeriesExpansion::expand(client, comp, startDate, endDate,
+                                                          data->expansionExceptions()));
+        } else {
+            icalcomponent *ical = e_cal_component_get_icalcomponent(comp);
+            data->appendResult(data->isSummaryFetch() ? data->summaryComponent(ical) :
+                                                        icalcomponent_new_clone(ical));
+        }
+    }
+    data->clearExpansionComponents();
+    itemsAsyncStart(data);
+}
+
+void QOrganizerEDSEngine::itemsAsyncViewReady(GObject *source,
+                                              GAsyncResult *res,
+                                              FetchRequestData *data)
+{
+    Q_UNUSED(source);
+    GError *gError = 0;
+    ECalClientView *view = 0;
+    e_cal_client_get_view_finish(data->client(), res, &view, &gError);
+    if (gError) {
+        qWarning() << "Fail to open view" << gError->message;
+        g_error_free(gError);
+        gError = 0;
+        if (data->isLive()) {
+            data->finish(QOrganizerManager::InvalidCollectionError);
+        } else {
+            releaseRequestData(data);
+        }
+        return;
+    }
+
+    // check if request was destroyed by the caller
+    if (!data->isLive()) {
+        g_object_unref(view);
+        releaseRequestData(data);
+        return;
+    }
+
+    data->setView(view);
+    g_signal_connect(view,
+                     "objects-added",
+                     (GCallback) QOrganizerEDSEngine::itemsAsyncViewObjectsAdded,
+                     data);
+    g_signal_connect(view,
+                     "complete",
+                     (GCallback) QOrganizerEDSEngine::itemsAsyncViewComplete,
+                     data);
+
+    // the components will be filtered again when received in case of the backend ignore it
+    GSList *fields = data->summaryFields();
+    e_cal_client_view_set_fields_of_interest(view, fields, &gError);
+    g_slist_free_full(fields, g_free);
+    if (gError) {
+        qWarning() << "Fail to set view fields of interest" << gError->message;
+        g_error_free(gError);
+        gError = 0;
+    }
+
+    e_cal_client_view_set_flags(view, E_CAL_CLIENT_VIEW_FLAGS_NOTIFY_INITIAL, NULL);
+    e_cal_client_view_start(view, &gError);
+    if (gError) {
+        qWarning() << "Fail to start view" << gError->message;
+        g_error_free(gError);
+        gError = 0;
+        data->clearView();
+        data->finish(QOrganizerManager::InvalidCollectionError);
+    }
+}
+
+void QOrganizerEDSEngine::itemsAsyncViewObjectsAdded(ECalClientView *view,
+                                                     GSList *objects,
+                                                     FetchRequestData *data)
+{
+    Q_UNUSED(view);
+    if (!data->isLive()) {
+        return;
+    }
+
+    for (GSList *l = objects; l; l = l->next) {
+        data->appendResult(data->summaryComponent(static_cast<icalcomponent*>(l->data)));
+    }
+}
+
+void QOrganizerEDSEngine::itemsAsyncViewComplete(ECalClientView *view,
+                                                 const GError *error,
+                                                 FetchRequestData *data)
+{
+    Q_UNUSED(view);
+    data->clearView();
+    data->endPhase(RequestStats::DBusCall);
+
+    if (error) {
+        qWarning() << "Fail to list events in calendar" << error->message;
+    }
+
+    if (data->isLive()) {
         itemsAsyncStart(data);
     } else {
         releaseRequestData(data);
@@ -299,16 +562,17 @@ void QOrganizerEDSEngine::itemsByIdAsyncStart(FetchByIdRequestData *data)
 
     QString id = data->nextId();
     if (!id.isEmpty()) {
-        QStringList ids = id.split("/");
-        if (ids.length() == 2) {
-            Q_ASSERT(ids.length() == 2);
-            QString collectionId = ids[0];
-            QString rId;
-            QString itemId = QOrganizerEDSEngineId::toComponentId(ids[1], &rId);
+        QString collectionId;
+        QString itemId;
+        QString rId;
+        if (QOrganizerEDSEngineId::splitItemId(id, &collectionId, &itemId, &rId)) {
 
+            data->beginPhase(RequestStats::ClientConnect);
             EClient *client = data->parent()->d->m_sourceRegistry->client(collectionId);
+            data->endPhase(RequestStats::ClientConnect);
             if (client) {
                 data->setClient(client);
+                data->beginPhase(RequestStats::DBusCall);
                 e_cal_client_get_object(data->client(),
                                         itemId.toUtf8().data(),
                                         rId.toUtf8().data(),
@@ -336,6 +600,7 @@ void QOrganizerEDSEngine::itemsByIdAsyncListed(GObject *client,
     GError *gError = 0;
     icalcomponent *icalComp = 0;
     e_cal_client_get_object_finish(data->client(), res, &icalComp, &gError);
+    data->endPhase(RequestStats::DBusCall);
     if (gError) {
         qWarning() << "Fail to list events in calendar" << gError->message;
         g_error_free(gError);
@@ -345,10 +610,12 @@ void QOrganizerEDSEngine::itemsByIdAsyncListed(GObject *client,
         GSList *events = g_slist_append(0, icalComp);
         QList<QOrganizerItem> items;
         QOrganizerItemFetchByIdRequest *req = data->request<QOrganizerItemFetchByIdRequest>();
+        data->beginPhase(RequestStats::Parse);
         items = data->parent()->parseEvents(data->currentCollectionId(),
                                             events,
                                             true,
                                             req->fetchHint().detailTypesHint());
+        data->endPhase(RequestStats::Parse);
         Q_ASSERT(items.size() == 1);
         data->appendResult(items[0]);
         g_slist_free_full(events, (GDestroyNotify) icalcomponent_free);
@@ -368,9 +635,12 @@ void QOrganizerEDSEngine::itemOcurrenceAsync(QOrganizerItemOccurrenceFetchReques
     QString rId;
     QString cId = QOrganizerEDSEngineId::toComponentId(req->parentItem().id(), &rId);
 
+    data->beginPhase(RequestStats::ClientConnect);
     EClient *client = data->parent()->d->m_sourceRegistry->client(req->parentItem().collectionId().toString());
+    data->endPhase(RequestStats::ClientConnect);
     if (client) {
         data->setClient(client);
+        data->beginPhase(RequestStats::DBusCall);
         e_cal_client_get_object(data->client(),
                                 cId.toUtf8(), rId.toUtf8(),
                                 data->cancellable(),
@@ -438,6 +708,7 @@ void QOrganizerEDSEngine::itemOcurrenceAsyncListed(ECalComponent *comp,
 
 void QOrganizerEDSEngine::itemOcurrenceAsyncDone(FetchOcurrenceData *data)
 {
+    data->endPhase(RequestStats::DBusCall);
     if (data->isLive()) {
         data->finish();
     } else {
@@ -543,12 +814,206 @@ QList<QOrganizerItem> QOrganizerEDSEngine::itemsForExport(const QDateTime &start
                                                                  const QOrganizerItemFetchHint &fetchHint,
                                                                  QOrganizerManager::Error *error)
 {
-    qWarning() << Q_FUNC_INFO << "Not implemented";
+    QOrganizerItemFetchRequest *req = new QOrganizerItemFetchRequest(this);
+
+    req->setFilter(filter);
+    req->setStartDate(startDateTime);
+    req->setEndDate(endDateTime);
+    req->setSorting(sortOrders);
+    req->setFetchHint(fetchHint);
+    req->setProperty(FETCH_FOR_EXPORT_PROPERTY, true);
+
+    startRequest(req);
+    waitForRequestFinished(req, 0);
+
     if (error) {
-        *error = QOrganizerManager::NotSupportedError;
+        *error = req->error();
+    }
+
+    req->deleteLater();
+    return req->items();
+}
+
+QList<QPair<QOrganizerItemId, QDateTime> > QOrganizerEDSEngine::upcomingAlarms(const QDateTime &startDateTime,
+                                                                              const QDateTime &endDateTime)
+{
+    if (!startDateTime.isValid() || !endDateTime.isValid() || (endDateTime <= startDateTime)) {
+        return QList<QPair<QOrganizerItemId, QDateTime> >();
+    }
+    d->m_sourceRegistry->waitForLoaded();
+    return d->m_alarmIndex->alarms(startDateTime, endDateTime);
+}
+
+QList<QPair<QDateTime, QDateTime> > QOrganizerEDSEngine::busyIntervals(const QDateTime &startDateTime,
+                                                                       const QDateTime &endDateTime,
+                                                                       const QList<QOrganizerCollectionId> &collectionIds,
+                                                                       QOrganizerManager::Error *error)
+{
+    QList<QPair<QDateTime, QDateTime> > result;
+    if (!startDateTime.isValid() || !endDateTime.isValid() || (endDateTime <= startDateTime)) {
+        if (error) {
+            *error = QOrganizerManager::BadArgumentError;
+        }
+        return result;
+    }
+
+    d->m_sourceRegistry->waitForLoaded();
+    QStringList collections;
+    if (collectionIds.isEmpty()) {
+        collections = d->m_sourceRegistry->collectionsIds();
+    } else {
+        Q_FOREACH(const QOrganizerCollectionId &id, collectionIds) {
+            collections << id.toString();
+        }
+    }
+
+    FreeBusy freeBusy(startDateTime.toTime_t(), endDateTime.toTime_t());
+    QList<EClient*> clients;
+    Q_FOREACH(const QString &collectionId, collections) {
+        // only event collections take time
+        QOrganizerEDSCollectionEngineId *edsId = d->m_sourceRegistry->collectionEngineId(collectionId);
+        if (edsId && (edsId->m_sourceType != E_CAL_CLIENT_SOURCE_TYPE_EVENTS)) {
+            continue;
+        }
+
+        EClient *client = d->m_sourceRegistry->client(collectionId);
+        if (!client) {
+            if (error) {
+                *error = QOrganizerManager::InvalidCollectionError;
+            }
+            Q_FOREACH(EClient *c, clients) {
+                g_object_unref(c);
+            }
+            return result;
+        }
+        clients << client;
+    }
+
+    Q_FOREACH(EClient *client, clients) {
+        freeBusy.collect(E_CAL_CLIENT(client));
+    }
+    freeBusy.wait();
+    Q_FOREACH(EClient *client, clients) {
+        g_object_unref(client);
+    }
+
+    Q_FOREACH(const FreeBusy::Interval &interval, freeBusy.busyIntervals()) {
+        result << qMakePair(QDateTime::fromTime_t(interval.first),
+                            QDateTime::fromTime_t(interval.second));
+    }
+    if (error) {
+        *error = QOrganizerManager::NoError;
+    }
+    return result;
+}
+
+bool QOrganizerEDSEngine::exportItems(QIODevice *device,
+                                      const QList<QOrganizerCollectionId> &collectionIds,
+                                      QOrganizerManager::Error *error)
+{
+    d->m_sourceRegistry->waitForLoaded();
+    QStringList collections;
+    if (collectionIds.isEmpty()) {
+        collections = d->m_sourceRegistry->collectionsIds();
+    } else {
+        Q_FOREACH(const QOrganizerCollectionId &id, collectionIds) {
+            collections << id.toString();
+        }
+    }
+
+    QOrganizerManager::Error exportError = QOrganizerManager::NoError;
+    if (!device || !device->isWritable()) {
+        exportError = QOrganizerManager::BadArgumentError;
+    } else {
+        CalendarExporter exporter(d->m_sourceRegistry, device);
+        QObject::connect(&exporter, &CalendarExporter::progress,
+                         [this](const QString &collectionId, int exportedCount) {
+            Q_EMIT exportProgress(QOrganizerCollectionId::fromString(collectionId), exportedCount);
+        });
+        Q_FOREACH(const QString &collectionId, collections) {
+            if (!exporter.exportCollection(collectionId, &exportError)) {
+                break;
+            }
+        }
+    }
+
+    if (error) {
+        *error = exportError;
+    }
+    return (exportError == QOrganizerManager::NoError);
+}
+
+bool QOrganizerEDSEngine::importItems(QIODevice *device,
+                                      const QOrganizerCollectionId &collectionId,
+                                      QMap<int, QOrganizerManager::Error> *errorMap,
+                                      QOrganizerManager::Error *error)
+{
+    QOrganizerManager::Error importError = QOrganizerManager::NoError;
+    QMap<int, QOrganizerManager::Error> importErrors;
+
+    d->m_sourceRegistry->waitForLoaded();
+    QString collection = collectionId.isNull() ?
+                d->m_sourceRegistry->defaultCollection().id().toString() :
+                collectionId.toString();
+    EClient *client = d->m_sourceRegistry->client(collection);
+    if (!device || !device->isReadable()) {
+        importError = QOrganizerManager::BadArgumentError;
+    } else if (!client) {
+        importError = QOrganizerManager::InvalidCollectionError;
+    } else {
+        CalendarImporter importer(E_CAL_CLIENT(client), device);
+        if (!importer.importItems(&importErrors)) {
+            importError = importErrors.first();
+        }
+    }
+
+    if (client) {
+        g_object_unref(client);
+    }
+    if (errorMap) {
+        *errorMap = importErrors;
+    }
+    if (error) {
+        *error = importError;
+    }
+    return (importError == QOrganizerManager::NoError);
+}
+
+bool QOrganizerEDSEngine::itemChangesSince(const QOrganizerCollectionId &collectionId,
+                                           const QString &revision,
+                                           QList<QOrganizerItemId> *addedIds,
+                                           QList<QOrganizerItemId> *changedIds,
+                                           QList<QOrganizerItemId> *removedIds,
+                                           QString *currentRevision,
+                                           QOrganizerManager::Error *error)
+{
+    d->m_sourceRegistry->waitForLoaded();
+
+    QOrganizerManager::Error changesError = QOrganizerManager::NoError;
+    QString collection = collectionId.toString();
+    QString current;
+    if (!addedIds || !changedIds || !removedIds) {
+        changesError = QOrganizerManager::BadArgumentError;
+    } else if (!d->m_sourceRegistry->collectionsIds().contains(collection)) {
+        changesError = QOrganizerManager::InvalidCollectionError;
+    } else {
+        current = d->m_sourceRegistry->revision(collection);
+        addedIds->clear();
+        changedIds->clear();
+        removedIds->clear();
+        if (!d->m_changeJournal->changesSince(collection, revision, current,
+                                              addedIds, changedIds, removedIds)) {
+            changesError = QOrganizerManager::DoesNotExistError;
+        }
     }
-    return QList<QOrganizerItem>();
 
+    if (currentRevision) {
+        *currentRevision = current;
+    }
+    if (error) {
+        *error = changesError;
+    }
+    return (changesError == QOrganizerManager::NoError);
 }
 
 void QOrganizerEDSEngine::saveItemsAsync(QOrganizerItemSaveRequest *req)
@@ -595,7 +1060,9 @@ void QOrganizerEDSEngine::saveItemsAsyncStart(SaveRequestData *data)
             collectionId = data->parent()->d->m_sourceRegistry->defaultCollection().id().toString();
         }
 
+        data->beginPhase(RequestStats::ClientConnect);
         EClient *client = data->parent()->d->m_sourceRegistry->client(collectionId);
+        data->endPhase(RequestStats::ClientConnect);
         if (!client) {
             Q_FOREACH(const QOrganizerItem &i, items) {
                 data->appendResult(i, QOrganizerManager::InvalidCollectionError);
@@ -614,6 +1081,7 @@ void QOrganizerEDSEngine::saveItemsAsyncStart(SaveRequestData *data)
                                    &hasRecurrence);
         if (comps) {
             data->setWorkingItems(items);
+            data->beginPhase(RequestStats::DBusCall);
             if (createItems) {
                 e_cal_client_create_objects(data->client(),
                                             comps,
@@ -656,6 +1124,14 @@ void QOrganizerEDSEngine::saveItemsAsyncModified(GObject *source_object,
     e_cal_client_modify_objects_finish(E_CAL_CLIENT(data->client()),
                                        res,
                                        &gError);
+    data->endPhase(RequestStats::DBusCall);
+
+    // do not wait for the view notification, the series can be fetched right away
+    RecurrenceCache *cache = RecurrenceCache::instance();
+    Q_FOREACH(const QOrganizerItem &i, data->workingItems()) {
+        QString rId;
+        cache->remove(i.collectionId().toString(), QOrganizerEDSEngineId::toComponentId(i.id(), &rId));
+    }
 
     if (gError) {
         qWarning() << "Fail to modify items" << gError->message;
@@ -689,6 +1165,7 @@ void QOrganizerEDSEngine::saveItemsAsyncCreated(GObject *source_object,
                                        res,
                                        &uids,
                                        &gError);
+    data->endPhase(RequestStats::DBusCall);
     if (gError) {
         qWarning() << "Fail to create items:" << (void*) data << gError->message;
         g_error_free(gError);
@@ -704,20 +1181,26 @@ void QOrganizerEDSEngine::saveItemsAsyncCreated(GObject *source_object,
         if (currentCollectionId.isEmpty()) {
             currentCollectionId = data->parent()->defaultCollection(0).id().toString();
         }
+        // all items share the collection id owned by the registry
+        QOrganizerCollectionId collectionId;
+        QOrganizerEDSCollectionEngineId *edsCollectionId = data->parent()->d->m_sourceRegistry->collectionEngineId(currentCollectionId);
+        if (edsCollectionId) {
+            collectionId = QOrganizerCollectionId(edsCollectionId);
+        } else {
+            collectionId = QOrganizerCollectionId(new QOrganizerEDSCollectionEngineId(currentCollectionId));
+        }
         QList<QOrganizerItem> items = data->workingItems();
-        for(uint i=0, iMax=g_slist_length(uids); i < iMax; i++) {
+        int i = 0;
+        for(GSList *l = uids; l && (i < items.size()); l = l->next, i++) {
             QOrganizerItem &item = items[i];
-            const gchar *uid = static_cast<const gchar*>(g_slist_nth_data(uids, i));
+            const gchar *uid = static_cast<const gchar*>(l->data);
 
             QOrganizerEDSEngineId *eid = new QOrganizerEDSEngineId(currentCollectionId,
-                                                                   QString::fromUtf8(uid));
+                                                                   QString::fromUtf8(uid),
+                                                                   QString());
             item.setId(QOrganizerItemId(eid));
-            item.setGuid(QString("%1/%2")
-                         .arg(eid->m_collectionId)
-                         .arg(eid->m_itemId));
-
-            QOrganizerEDSCollectionEngineId *edsCollectionId = new QOrganizerEDSCollectionEngineId(currentCollectionId);
-            item.setCollectionId(QOrganizerCollectionId(edsCollectionId));
+            item.setGuid(eid->toString());
+            item.setCollectionId(collectionId);
         }
         g_slist_free_full(uids, g_free);
         data->appendResults(items);
@@ -775,12 +1258,16 @@ void QOrganizerEDSEngine::removeItemsByIdAsyncStart(RemoveByIdRequestData *data)
 
     QString collectionId = data->next();
     for(; !collectionId.isNull(); collectionId = data->next()) {
+        data->beginPhase(RequestStats::ClientConnect);
         EClient *client = data->parent()->d->m_sourceRegistry->client(collectionId);
+        data->endPhase(RequestStats::ClientConnect);
         data->setClient(client);
         g_object_unref(client);
         GSList *ids = data->compIds();
         GError *gError = 0;
+        data->beginPhase(RequestStats::DBusCall);
         e_cal_client_remove_objects_sync(data->client(), ids, E_CAL_OBJ_MOD_THIS, 0, 0);
+        data->endPhase(RequestStats::DBusCall);
         if (gError) {
             qWarning() << "Fail to remove Items" << gError->message;
             g_error_free(gError);
@@ -815,13 +1302,17 @@ void QOrganizerEDSEngine::removeItemsAsyncStart(RemoveRequestData *data)
 
     QOrganizerCollectionId collection = data->next();
     for(; !collection.isNull(); collection = data->next()) {
+        data->beginPhase(RequestStats::ClientConnect);
         EClient *client = data->parent()->d->m_sourceRegistry->client(collection.toString());
         Q_ASSERT(client);
+        data->endPhase(RequestStats::ClientConnect);
         data->setClient(client);
         g_object_unref(client);
         GSList *ids = data->compIds();
         GError *gError = 0;
+        data->beginPhase(RequestStats::DBusCall);
         e_cal_client_remove_objects_sync(data->client(), ids, E_CAL_OBJ_MOD_THIS, 0, 0);
+        data->endPhase(RequestStats::DBusCall);
         if (gError) {
             qWarning() << "Fail to remove Items" << gError->message;
             g_error_free(gError);
@@ -853,6 +1344,9 @@ bool QOrganizerEDSEngine::removeItems(const QList<QOrganizerItemId> &itemIds,
 
 QOrganizerCollection QOrganizerEDSEngine::defaultCollection(QOrganizerManager::Error* error)
 {
+    if (!d->m_sourceRegistry->hasCachedCollections()) {
+        d->m_sourceRegistry->waitForLoaded();
+    }
     if (error) {
         *error = QOrganizerManager::NoError;
     }
@@ -862,6 +1356,7 @@ QOrganizerCollection QOrganizerEDSEngine::defaultCollection(QOrganizerManager::E
 QOrganizerCollection QOrganizerEDSEngine::collection(const QOrganizerCollectionId& collectionId,
                                                      QOrganizerManager::Error* error)
 {
+    d->m_sourceRegistry->waitForLoaded();
     QOrganizerCollection collection = d->m_sourceRegistry->collection(collectionId.toString());
     if (collection.id().isNull() && error) {
         *error = QOrganizerManager::DoesNotExistError;
@@ -872,20 +1367,20 @@ QOrganizerCollection QOrganizerEDSEngine::collection(const QOrganizerCollectionI
 
 QList<QOrganizerCollection> QOrganizerEDSEngine::collections(QOrganizerManager::Error* error)
 {
-    QOrganizerCollectionFetchRequest *req = new QOrganizerCollectionFetchRequest(this);
-
-    startRequest(req);
-    waitForRequestFinished(req, 0);
-
+    // the registry keeps a snapshot of the collections which is shared
+    // with the callers, no need to go through a fetch request
+    if (!d->m_sourceRegistry->hasCachedCollections()) {
+        d->m_sourceRegistry->waitForLoaded();
+    }
     if (error) {
-        *error = req->error();
+        *error = QOrganizerManager::NoError;
     }
+    return d->m_sourceRegistry->collections();
+}
 
-    if (req->error() == QOrganizerManager::NoError) {
-        return req->collections();
-    } else {
-        return QList<QOrganizerCollection>();
-    }
+quint64 QOrganizerEDSEngine::collectionsGeneration() const
+{
+    return d->m_sourceRegistry->generation();
 }
 
 bool QOrganizerEDSEngine::saveCollection(QOrganizerCollection* collection, QOrganizerManager::Error* error)
@@ -962,14 +1457,18 @@ gboolean QOrganizerEDSEngine::saveCollectionUpdateAsyncStart(SaveCollectionReque
         return FALSE;
     }
 
-    ESource *source = data->nextSourceToUpdate();
-    if (source) {
+    QList<ESource*> sources = data->beginUpdate();
+    if (sources.isEmpty()) {
+        data->finish();
+        return FALSE;
+    }
+
+    // the writes are independent, dispatch all of them at once
+    Q_FOREACH(ESource *source, sources) {
         e_source_write(source,
                        data->cancellable(),
                        (GAsyncReadyCallback) QOrganizerEDSEngine::saveCollectionUpdateAsynCommited,
                        data);
-    } else {
-        data->finish();
     }
     return FALSE;
 }
@@ -991,8 +1490,13 @@ void QOrganizerEDSEngine::saveCollectionUpdateAsynCommited(ESource *source,
         data->commitSourceUpdated(source);
     }
 
+    // wait for the other writes
+    if (!data->endUpdate()) {
+        return;
+    }
+
     if (data->isLive()) {
-        g_idle_add((GSourceFunc) saveCollectionUpdateAsyncStart, data);
+        data->finish();
     } else {
         releaseRequestData(data);
     }
@@ -1024,12 +1528,10 @@ void QOrganizerEDSEngine::removeCollectionAsync(QtOrganizer::QOrganizerCollectio
     }
 
     RemoveCollectionRequestData *requestData = new RemoveCollectionRequestData(this, req);
-    removeCollectionAsyncStart(0, 0, requestData);
+    removeCollectionAsyncStart(requestData);
 }
 
-void QOrganizerEDSEngine::removeCollectionAsyncStart(GObject *sourceObject,
-                                                     GAsyncResult *res,
-                                                     RemoveCollectionRequestData *data)
+void QOrganizerEDSEngine::removeCollectionAsyncStart(RemoveCollectionRequestData *data)
 {
     // check if request was destroyed by the caller
     if (!data->isLive()) {
@@ -1037,61 +1539,121 @@ void QOrganizerEDSEngine::removeCollectionAsyncStart(GObject *sourceObject,
         return;
     }
 
-    if (sourceObject && res) {
-        GError *gError = 0;
-        if (data->remoteDeletable()) {
-            e_source_remote_delete_finish(E_SOURCE(sourceObject), res, &gError);
-        } else {
-            e_source_remove_finish(E_SOURCE(sourceObject), res, &gError);
-        }
-        if (gError) {
-            qWarning() << "Fail to remove collection" << gError->message;
-            g_error_free(gError);
-            data->commit(QOrganizerManager::InvalidCollectionError);
-        } else {
-            data->commit();
-        }
-    }
-
-    ESource *source = data->begin();
-    if (source) {
-        ESourceRegistry *registry = NULL;
-        gboolean accountRemovable = e_source_get_removable(source);
-        gboolean remoteDeletable = e_source_get_remote_deletable(source);
-
-        if ((accountRemovable == FALSE) && (remoteDeletable == FALSE)) {
-            qWarning() << "Account not removable will refetch source";
-            // WORKAROUND: Sometimes EDS take longer to make a account removable with this we
-            // force EDS to update sources infomation
-            registry  = e_source_registry_new_sync(NULL, NULL);
-            source = e_source_registry_ref_source(registry, e_source_get_uid(source));
-            accountRemovable = e_source_get_removable(source);
-            remoteDeletable = e_source_get_remote_deletable(source);
-        }
-
-        if (remoteDeletable == TRUE) {
-            data->setRemoteDeletable(true);
-            e_source_remote_delete(source, data->cancellable(),
-                                   (GAsyncReadyCallback) QOrganizerEDSEngine::removeCollectionAsyncStart,
-                                   data);
-        } else if (accountRemovable == TRUE) {
-            e_source_remove(source, data->cancellable(),
-                            (GAsyncReadyCallback) QOrganizerEDSEngine::removeCollectionAsyncStart,
-                            data);
-        } else {
-            qWarning() << "Source not removable" << e_source_get_uid(source);
-            data->commit(QOrganizerManager::InvalidCollectionError);
-            removeCollectionAsyncStart(0, 0, data);
-        }
+    QList<RemoveCollectionOperation*> operations = data->begin();
+    if (operations.isEmpty()) {
+        data->finish();
+        return;
+    }
 
-        if (registry) {
-            g_object_unref(source);
-            g_object_unref(registry);
-        }
+    // the collections are independent, remove all of them at once
+    Q_FOREACH(RemoveCollectionOperation *op, operations) {
+        removeCollectionAsyncRemove(op);
+    }
+}
+
+void QOrganizerEDSEngine::removeCollectionAsyncRemove(RemoveCollectionOperation *op)
+{
+    RemoveCollectionRequestData *data = op->data;
+    gboolean accountRemovable = e_source_get_removable(op->source);
+    gboolean remoteDeletable = e_source_get_remote_deletable(op->source);
+
+    if (remoteDeletable == TRUE) {
+        op->remoteDeletable = true;
+        e_source_remote_delete(op->source, data->cancellable(),
+                               (GAsyncReadyCallback) QOrganizerEDSEngine::removeCollectionAsyncRemoved,
+                               op);
+    } else if (accountRemovable == TRUE) {
+        e_source_remove(op->source, data->cancellable(),
+                        (GAsyncReadyCallback) QOrganizerEDSEngine::removeCollectionAsyncRemoved,
+                        op);
+    } else if (!op->waiting) {
+        // WORKAROUND: Sometimes EDS take longer to make a account removable, the registry
+        // source is updated when it does
+        qWarning() << "Account not removable will wait for source" << e_source_get_uid(op->source);
+        op->waiting = true;
+        op->removableChangedId = g_signal_connect(op->source,
+                                                  "notify::removable",
+                                                  (GCallback) QOrganizerEDSEngine::removeCollectionAsyncSourceChanged,
+                                                  op);
+        op->deletableChangedId = g_signal_connect(op->source,
+                                                  "notify::remote-deletable",
+                                                  (GCallback) QOrganizerEDSEngine::removeCollectionAsyncSourceChanged,
+                                                  op);
+        op->timeoutId = g_timeout_add(REMOVE_COLLECTION_REMOVABLE_TIMEOUT,
+                                      (GSourceFunc) QOrganizerEDSEngine::removeCollectionAsyncTimeout,
+                                      op);
     } else {
-        data->finish();
+        qWarning() << "Source not removable" << e_source_get_uid(op->source);
+        data->commit(op, QOrganizerManager::InvalidCollectionError);
+        removeCollectionAsyncDone(op);
+    }
+}
+
+void QOrganizerEDSEngine::removeCollectionAsyncSourceChanged(ESource *source,
+                                                             GParamSpec *pspec,
+                                                             RemoveCollectionOperation *op)
+{
+    Q_UNUSED(pspec);
+    if (!op->data->isLive()) {
+        removeCollectionAsyncDone(op);
+        return;
     }
 
+    if (e_source_get_removable(source) || e_source_get_remote_deletable(source)) {
+        RemoveCollectionRequestData::stopWaiting(op);
+        removeCollectionAsyncRemove(op);
+    }
+}
+
+gboolean QOrganizerEDSEngine::removeCollectionAsyncTimeout(RemoveCollectionOperation *op)
+{
+    // the source is removed with g_source_remove by stopWaiting otherwise
+    op->timeoutId = 0;
+    RemoveCollectionRequestData::stopWaiting(op);
+    if (op->data->isLive()) {
+        removeCollectionAsyncRemove(op);
+    } else {
+        removeCollectionAsyncDone(op);
+    }
+    return FALSE;
+}
+
+void QOrganizerEDSEngine::removeCollectionAsyncRemoved(GObject *sourceObject,
+                                                       GAsyncResult *res,
+                                                       RemoveCollectionOperation *op)
+{
+    GError *gError = 0;
+    if (op->remoteDeletable) {
+        e_source_remote_delete_finish(E_SOURCE(sourceObject), res, &gError);
+    } else {
+        e_source_remove_finish(E_SOURCE(sourceObject), res, &gError);
+    }
+
+    if (gError) {
+        qWarning() << "Fail to remove collection" << gError->message;
+        g_error_free(gError);
+        if (op->data->isLive()) {
+            op->data->commit(op, QOrganizerManager::InvalidCollectionError);
+        }
+    } else if (op->data->isLive()) {
+        op->data->commit(op);
+    }
+    removeCollectionAsyncDone(op);
+}
+
+void QOrganizerEDSEngine::removeCollectionAsyncDone(RemoveCollectionOperation *op)
+{
+    RemoveCollectionRequestData *data = op->data;
+    // wait for the other collections
+    if (!data->end(op)) {
+        return;
+    }
+
+    if (data->isLive()) {
+        data->finish();
+    } else {
+        releaseRequestData(data);
+    }
 }
 
 void QOrganizerEDSEngine::releaseRequestData(RequestData *data)
@@ -1101,6 +1663,7 @@ void QOrganizerEDSEngine::releaseRequestData(RequestData *data)
 
 void QOrganizerEDSEngine::requestDestroyed(QOrganizerAbstractRequest* req)
 {
+    m_pendingRequests.removeAll(req);
     RequestData *data = m_runningRequests.take(req);
     if (data) {
         data->cancel();
@@ -1112,6 +1675,18 @@ bool QOrganizerEDSEngine::startRequest(QOrganizerAbstractRequest* req)
     if (!req)
         return false;
 
+    // requests are started once the sources are known, the collections
+    // can be listed from the cache before that
+    if (!d->m_sourceRegistry->isLoaded() &&
+        !((req->type() == QOrganizerAbstractRequest::CollectionFetchRequest) &&
+          d->m_sourceRegistry->hasCachedCollections())) {
+        if (!m_pendingRequests.contains(req)) {
+            m_pendingRequests << req;
+            updateRequestState(req, QOrganizerAbstractRequest::ActiveState);
+        }
+        return true;
+    }
+
     switch (req->type())
     {
         case QOrganizerAbstractRequest::ItemFetchRequest:
@@ -1155,6 +1730,11 @@ bool QOrganizerEDSEngine::startRequest(QOrganizerAbstractRequest* req)
 
 bool QOrganizerEDSEngine::cancelRequest(QOrganizerAbstractRequest* req)
 {
+    if (m_pendingRequests.removeAll(req) > 0) {
+        updateRequestState(req, QOrganizerAbstractRequest::CanceledState);
+        return true;
+    }
+
     RequestData *data = m_runningRequests.value(req);
     if (data) {
         data->cancel();
@@ -1168,6 +1748,18 @@ bool QOrganizerEDSEngine::waitForRequestFinished(QOrganizerAbstractRequest* req,
 {
     Q_ASSERT(req);
 
+    QElapsedTimer elapsed;
+    elapsed.start();
+    if (m_pendingRequests.contains(req)) {
+        // the request is started as soon as the registry is loaded
+        if (!d->m_sourceRegistry->waitForLoaded(msecs)) {
+            return false;
+        }
+        if (msecs > 0) {
+            msecs = qMax(msecs - int(elapsed.elapsed()), 1);
+        }
+    }
+
     RequestData *data = m_runningRequests.value(req);
     if (data) {
         data->wait(msecs);
@@ -1270,6 +1862,19 @@ int QOrganizerEDSEngine::runningRequestCount() const
     return m_runningRequests.count();
 }
 
+QList<RequestStats> QOrganizerEDSEngine::requestStats() const
+{
+    return d->m_requestStats->stats();
+}
+
+QMap<QString, QString> QOrganizerEDSEngine::metrics() const
+{
+    QMap<QString, QString> metrics = EngineMetrics::instance()->toMap();
+    metrics.insert("running-requests", QString::number(m_runningRequests.count()));
+    metrics.insert("pending-requests", QString::number(m_pendingRequests.count()));
+    return metrics;
+}
+
 void QOrganizerEDSEngine::onSourceAdded(const QString &collectionId)
 {
     d->watch(collectionId);
@@ -1282,6 +1887,15 @@ void QOrganizerEDSEngine::onSourceAdded(const QString &collectionId)
     Q_EMIT collectionsModified(ops);
 }
 
+void QOrganizerEDSEngine::onSourceRegistryLoaded()
+{
+    QList<QOrganizerAbstractRequest*> pending = m_pendingRequests;
+    m_pendingRequests.clear();
+    Q_FOREACH(QOrganizerAbstractRequest *req, pending) {
+        startRequest(req);
+    }
+}
+
 void QOrganizerEDSEngine::onSourceRemoved(const QString &collectionId)
 {
     d->unWatch(collectionId);
@@ -1316,21 +1930,21 @@ QDateTime QOrganizerEDSEngine::fromIcalTime(struct icaltimetype value, const cha
 
     // check if ialtimetype contais a time and timezone
     if (!allDayEvent && tzId) {
-        QByteArray tzLocationName;
-        icaltimezone *timezone = icaltimezone_get_builtin_timezone_from_tzid(tzId);
+        TimeZoneCache *cache = TimeZoneCache::instance();
+        TimeZoneCache::Zone zone = cache->zone(tzId);
+        icaltimezone *timezone;
+        QTimeZone qTz;
 
         if (icaltime_is_utc(value)) {
-            tzLocationName = "UTC";
+            timezone = zone.tzIdZone;
+            qTz = cache->utcTimeZone();
         } else {
-            // fallback: sometimes the tzId contains the location name
-            if (!timezone) {
-                timezone = icaltimezone_get_builtin_timezone(tzId);
-            }
-            tzLocationName = QByteArray(icaltimezone_get_location(timezone));
+            // the cache already falls back to the location name lookup
+            timezone = zone.zone;
+            qTz = zone.qtZone;
         }
 
         tmTime = icaltime_as_timet_with_zone(value, timezone);
-        QTimeZone qTz(tzLocationName);
         return QDateTime::fromTime_t(tmTime, qTz);
     } else {
         tmTime = icaltime_as_timet(value);
@@ -1340,7 +1954,7 @@ QDateTime QOrganizerEDSEngine::fromIcalTime(struct icaltimetype value, const cha
         QDateTime tt;
         if (allDayEvent)
           tt = QDateTime(t.date(), QTime(0,0,0),
-                         QTimeZone(QTimeZone::systemTimeZoneId()));
+                         TimeZoneCache::instance()->systemTimeZone());
         else
           tt = QDateTime(t.date(), t.time(), Qt::UTC);
         return tt;
@@ -1359,7 +1973,7 @@ icaltimetype QOrganizerEDSEngine::fromQDateTime(const QDateTime &dateTime,
         case Qt::UTC:
         case Qt::OffsetFromUTC:
             // convert date to UTC timezone
-            tz = QTimeZone("UTC");
+            tz = TimeZoneCache::instance()->utcTimeZone();
             finalDate = finalDate.toTimeZone(tz);
             break;
         case Qt::TimeZone:
@@ -1370,7 +1984,7 @@ icaltimetype QOrganizerEDSEngine::fromQDateTime(const QDateTime &dateTime,
             }
             break;
         case Qt::LocalTime:
-            tz = QTimeZone(QTimeZone::systemTimeZoneId());
+            tz = TimeZoneCache::instance()->systemTimeZone();
             finalDate = finalDate.toTimeZone(tz);
             break;
         default:
@@ -1379,8 +1993,7 @@ icaltimetype QOrganizerEDSEngine::fromQDateTime(const QDateTime &dateTime,
     }
 
     if (tz.isValid()) {
-        icaltimezone *timezone = 0;
-        timezone = icaltimezone_get_builtin_timezone(tz.id().constData());
+        icaltimezone *timezone = TimeZoneCache::instance()->builtinTimezone(tz.id());
         *tzId = QByteArray(icaltimezone_get_tzid(timezone));
         return icaltime_from_timet_with_zone(finalDate.toTime_t(), allDay, timezone);
     } else {
@@ -1512,6 +2125,27 @@ void QOrganizerEDSEngine::parseYearRecurrence(struct icalrecurrencetype *rule, Q
 }
 
 void QOrganizerEDSEngine::parseRecurrence(ECalComponent *comp, QOrganizerItem *item)
+{
+    icalcomponent *ical = e_cal_component_get_icalcomponent(comp);
+    if (RecurrenceCache::recurrencePropertiesCount(ical) == 0) {
+        return;
+    }
+
+    // all occurrences of a series share the same rules, the id is parsed first
+    QOrganizerItemRecurrence rec;
+    QString collectionId = item->collectionId().toString();
+    RecurrenceCache *cache = RecurrenceCache::instance();
+    if (!cache->find(collectionId, ical, &rec)) {
+        parseRecurrenceDetail(comp, &rec);
+        cache->insert(collectionId, ical, rec);
+    }
+
+    if (!rec.isEmpty()) {
+        item->saveDetail(&rec);
+    }
+}
+
+void QOrganizerEDSEngine::parseRecurrenceDetail(ECalComponent *comp, QOrganizerItemRecurrence *rec)
 {
     // recurence
     if (e_cal_component_has_rdates(comp)) {
@@ -1528,9 +2162,7 @@ void QOrganizerEDSEngine::parseRecurrence(ECalComponent *comp, QOrganizerItem *i
         }
         e_cal_component_free_period_list(periodList);
 
-        QOrganizerItemRecurrence rec = item->detail(QOrganizerItemDetail::TypeRecurrence);
-        rec.setRecurrenceDates(dates);
-        item->saveDetail(&rec);
+        rec->setRecurrenceDates(dates);
     }
 
     if (e_cal_component_has_exdates(comp)) {
@@ -1546,9 +2178,7 @@ void QOrganizerEDSEngine::parseRecurrence(ECalComponent *comp, QOrganizerItem *i
         }
         e_cal_component_free_exdate_list(exdateList);
 
-        QOrganizerItemRecurrence irec = item->detail(QOrganizerItemDetail::TypeRecurrence);
-        irec.setExceptionDates(dates);
-        item->saveDetail(&irec);
+        rec->setExceptionDates(dates);
     }
 
     // rules
@@ -1606,9 +2236,7 @@ void QOrganizerEDSEngine::parseRecurrence(ECalComponent *comp, QOrganizerItem *i
         }
 
         if (!qRules.isEmpty()) {
-            QOrganizerItemRecurrence irec = item->detail(QOrganizerItemDetail::TypeRecurrence);
-            irec.setRecurrenceRules(qRules);
-            item->saveDetail(&irec);
+            rec->setRecurrenceRules(qRules);
         }
 
         e_cal_component_free_recur_list(ruleList);
@@ -1639,7 +2267,7 @@ void QOrganizerEDSEngine::parseLocation(ECalComponent *comp, QOrganizerItem *ite
     e_cal_component_get_location(comp, &location);
     if (location) {
         QOrganizerItemLocation ld = item->detail(QOrganizerItemDetail::TypeLocation);
-        ld.setLabel(QString::fromUtf8(location));
+        ld.setLabel(StringPool::instance()->intern(location));
         item->saveDetail(&ld);
     }
 }
@@ -1697,15 +2325,16 @@ void QOrganizerEDSEngine::parseStatus(ECalComponent *comp, QOrganizerItem *item)
 
 void QOrganizerEDSEngine::parseAttendeeList(ECalComponent *comp, QOrganizerItem *item)
 {
+    StringPool *pool = StringPool::instance();
     GSList *attendeeList = 0;
     e_cal_component_get_attendee_list(comp, &attendeeList);
     for (GSList *attendeeIter=attendeeList; attendeeIter != 0; attendeeIter = attendeeIter->next) {
         ECalComponentAttendee *attendee = static_cast<ECalComponentAttendee *>(attendeeIter->data);
         QOrganizerEventAttendee qAttendee;
 
-        qAttendee.setAttendeeId(QString::fromUtf8(attendee->member));
-        qAttendee.setName(QString::fromUtf8(attendee->cn));
-        qAttendee.setEmailAddress(QString::fromUtf8(attendee->value));
+        qAttendee.setAttendeeId(pool->intern(attendee->member));
+        qAttendee.setName(pool->intern(attendee->cn));
+        qAttendee.setEmailAddress(pool->intern(attendee->value));
 
         switch(attendee->role) {
         case ICAL_ROLE_REQPARTICIPANT:
@@ -1771,94 +2400,197 @@ void QOrganizerEDSEngine::parseExtendedDetails(ECalComponent *comp, QOrganizerIt
     }
 }
 
-QOrganizerItem *QOrganizerEDSEngine::parseEvent(ECalComponent *comp,
-                                                QList<QOrganizerItemDetail::DetailType> detailsHint)
+void QOrganizerEDSEngine::parseJournalTime(ECalComponent *comp, QOrganizerItem *item)
 {
-    QOrganizerItem *event;
-    if (hasRecurrence(comp)) {
-        event = new QOrganizerEventOccurrence();
-    } else {
-        event = new QOrganizerEvent();
-    }
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeEventTime)) {
-        parseStartTime(comp, event);
-        parseEndTime(comp, event);
+    ECalComponentDateTime dt;
+    e_cal_component_get_dtstart(comp, &dt);
+    if (dt.value) {
+        QDateTime qdtime = fromIcalTime(*dt.value, dt.tzid);
+        if (qdtime.isValid()) {
+          QOrganizerJournalTime jtime;
+          jtime.setEntryDateTime(qdtime);
+          item->saveDetail(&jtime);
+        }
     }
+    e_cal_component_free_datetime(&dt);
+}
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeRecurrence)) {
-        parseRecurrence(comp, event);
+QOrganizerEDSEngine::DetailsMask QOrganizerEDSEngine::detailsMask(const QList<QOrganizerItemDetail::DetailType> &detailsHint)
+{
+    // empty hint means all details
+    if (detailsHint.isEmpty()) {
+        return ~DetailsMask(0);
     }
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypePriority)) {
-        parsePriority(comp, event);
+    DetailsMask mask = 0;
+    Q_FOREACH(QOrganizerItemDetail::DetailType type, detailsHint) {
+        mask |= detailBit(type);
     }
+    return mask;
+}
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeLocation)) {
-        parseLocation(comp, event);
-    }
-    return event;
+template<void (*Parser)(ECalComponent *, QOrganizerItem *)>
+void QOrganizerEDSEngine::convertDetail(ECalComponent *comp, QOrganizerItem *item, DetailsMask mask)
+{
+    Q_UNUSED(mask);
+    Parser(comp, item);
 }
 
-QOrganizerItem *QOrganizerEDSEngine::parseToDo(ECalComponent *comp,
-                                               QList<QOrganizerItemDetail::DetailType> detailsHint)
+void QOrganizerEDSEngine::runConverters(const DetailConverterEntry *converters,
+                                        ECalComponent *comp,
+                                        QOrganizerItem *item,
+                                        DetailsMask mask)
 {
-    QOrganizerItem *todo;
-    if (hasRecurrence(comp)) {
-        todo = new QOrganizerTodoOccurrence();
-    } else {
-        todo = new QOrganizerTodo();
+    for (const DetailConverterEntry *c = converters; c->convert; c++) {
+        if (c->mask & mask) {
+            c->convert(comp, item, mask);
+        }
     }
+}
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeTodoTime)) {
-        parseTodoStartTime(comp, todo);
-        parseDueDate(comp, todo);
-    }
+#define REMINDER_DETAILS_MASK (detailBit(QOrganizerItemDetail::TypeReminder) | \
+                               detailBit(QOrganizerItemDetail::TypeVisualReminder) | \
+                               detailBit(QOrganizerItemDetail::TypeAudibleReminder) | \
+                               detailBit(QOrganizerItemDetail::TypeEmailReminder))
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeRecurrence)) {
-        parseRecurrence(comp, todo);
+// details supported by all component types
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::m_commonConverters[] = {
+    { detailBit(QOrganizerItemDetail::TypeDescription), &convertDetail<&QOrganizerEDSEngine::parseDescription> },
+    { detailBit(QOrganizerItemDetail::TypeDisplayLabel), &convertDetail<&QOrganizerEDSEngine::parseSummary> },
+    { detailBit(QOrganizerItemDetail::TypeComment), &convertDetail<&QOrganizerEDSEngine::parseComments> },
+    { detailBit(QOrganizerItemDetail::TypeTag), &convertDetail<&QOrganizerEDSEngine::parseTags> },
+    { REMINDER_DETAILS_MASK, &QOrganizerEDSEngine::parseReminders },
+    { detailBit(QOrganizerItemDetail::TypeEventAttendee), &convertDetail<&QOrganizerEDSEngine::parseAttendeeList> },
+    { detailBit(QOrganizerItemDetail::TypeExtendedDetail), &convertDetail<&QOrganizerEDSEngine::parseExtendedDetails> },
+    { 0, 0 }
+};
+
+template<>
+struct QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_EVENT>
+{
+    static const DetailConverterEntry converters[];
+    static const DetailConverterEntry timeConverters[];
+
+    static QOrganizerItem newItem(ECalComponent *comp)
+    {
+        if (hasRecurrence(comp)) {
+            return QOrganizerEventOccurrence();
+        }
+        return QOrganizerEvent();
     }
+};
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypePriority)) {
-        parsePriority(comp, todo);
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_EVENT>::converters[] = {
+    { detailBit(QOrganizerItemDetail::TypeEventTime), &convertDetail<&QOrganizerEDSEngine::parseStartTime> },
+    { detailBit(QOrganizerItemDetail::TypeEventTime), &convertDetail<&QOrganizerEDSEngine::parseEndTime> },
+    { detailBit(QOrganizerItemDetail::TypeRecurrence), &convertDetail<&QOrganizerEDSEngine::parseRecurrence> },
+    { detailBit(QOrganizerItemDetail::TypePriority), &convertDetail<&QOrganizerEDSEngine::parsePriority> },
+    { detailBit(QOrganizerItemDetail::TypeLocation), &convertDetail<&QOrganizerEDSEngine::parseLocation> },
+    { 0, 0 }
+};
+
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_EVENT>::timeConverters[] = {
+    { detailBit(QOrganizerItemDetail::TypeEventTime), &convertDetail<&QOrganizerEDSEngine::parseStartTime> },
+    { detailBit(QOrganizerItemDetail::TypeEventTime), &convertDetail<&QOrganizerEDSEngine::parseEndTime> },
+    { 0, 0 }
+};
+
+template<>
+struct QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_TODO>
+{
+    static const DetailConverterEntry converters[];
+    static const DetailConverterEntry timeConverters[];
+
+    static QOrganizerItem newItem(ECalComponent *comp)
+    {
+        if (hasRecurrence(comp)) {
+            return QOrganizerTodoOccurrence();
+        }
+        return QOrganizerTodo();
     }
+};
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeTodoProgress)) {
-        parseProgress(comp, todo);
-        parseStatus(comp, todo);
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_TODO>::converters[] = {
+    { detailBit(QOrganizerItemDetail::TypeTodoTime), &convertDetail<&QOrganizerEDSEngine::parseTodoStartTime> },
+    { detailBit(QOrganizerItemDetail::TypeTodoTime), &convertDetail<&QOrganizerEDSEngine::parseDueDate> },
+    { detailBit(QOrganizerItemDetail::TypeRecurrence), &convertDetail<&QOrganizerEDSEngine::parseRecurrence> },
+    { detailBit(QOrganizerItemDetail::TypePriority), &convertDetail<&QOrganizerEDSEngine::parsePriority> },
+    { detailBit(QOrganizerItemDetail::TypeTodoProgress), &convertDetail<&QOrganizerEDSEngine::parseProgress> },
+    { detailBit(QOrganizerItemDetail::TypeTodoProgress), &convertDetail<&QOrganizerEDSEngine::parseStatus> },
+    { 0, 0 }
+};
+
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_TODO>::timeConverters[] = {
+    { detailBit(QOrganizerItemDetail::TypeTodoTime), &convertDetail<&QOrganizerEDSEngine::parseTodoStartTime> },
+    { detailBit(QOrganizerItemDetail::TypeTodoTime), &convertDetail<&QOrganizerEDSEngine::parseDueDate> },
+    { 0, 0 }
+};
+
+template<>
+struct QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_JOURNAL>
+{
+    static const DetailConverterEntry converters[];
+    static const DetailConverterEntry timeConverters[];
+
+    static QOrganizerItem newItem(ECalComponent *comp)
+    {
+        Q_UNUSED(comp);
+        return QOrganizerJournal();
     }
+};
+
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_JOURNAL>::converters[] = {
+    { detailBit(QOrganizerItemDetail::TypeJournalTime), &convertDetail<&QOrganizerEDSEngine::parseJournalTime> },
+    { 0, 0 }
+};
+
+const QOrganizerEDSEngine::DetailConverterEntry QOrganizerEDSEngine::ComponentConverters<E_CAL_COMPONENT_JOURNAL>::timeConverters[] = {
+    { detailBit(QOrganizerItemDetail::TypeJournalTime), &convertDetail<&QOrganizerEDSEngine::parseJournalTime> },
+    { 0, 0 }
+};
 
-    return todo;
+template<ECalComponentVType VType>
+QOrganizerItem QOrganizerEDSEngine::parseComponent(ECalComponent *comp,
+                                                   QOrganizerEDSCollectionEngineId *collectionId,
+                                                   DetailsMask mask)
+{
+    QOrganizerItem item = ComponentConverters<VType>::newItem(comp);
+    // the converters may depend on the item collection
+    parseId(comp, &item, collectionId);
+    runConverters(ComponentConverters<VType>::converters, comp, &item, mask);
+    return item;
 }
 
-QOrganizerItem *QOrganizerEDSEngine::parseJournal(ECalComponent *comp,
-                                                  QList<QOrganizerItemDetail::DetailType> detailsHint)
+template<ECalComponentVType VType>
+QOrganizerItem QOrganizerEDSEngine::parseOccurrence(ECalComponent *comp,
+                                                    const QOrganizerItem &series,
+                                                    QOrganizerEDSCollectionEngineId *collectionId,
+                                                    DetailsMask mask)
 {
-    QOrganizerJournal *journal = new QOrganizerJournal();
+    // the copy shares all series details, only the id and time details get detached
+    QOrganizerItem item(series);
+    parseId(comp, &item, collectionId);
+    runConverters(ComponentConverters<VType>::timeConverters, comp, &item, mask);
+    return item;
+}
 
-    if (detailsHint.isEmpty() ||
-        detailsHint.contains(QOrganizerItemDetail::TypeJournalTime)) {
-        ECalComponentDateTime dt;
-        e_cal_component_get_dtstart(comp, &dt);
-        if (dt.value) {
-            QDateTime qdtime = fromIcalTime(*dt.value, dt.tzid);
-            if (qdtime.isValid()) {
-              QOrganizerJournalTime jtime;
-              jtime.setEntryDateTime(qdtime);
-              journal->saveDetail(&jtime);
-            }
-        }
-        e_cal_component_free_datetime(&dt);
+bool QOrganizerEDSEngine::seriesKey(ECalComponent *comp, SeriesKey *key)
+{
+    // detached exceptions do not carry the series rules and are parsed on their own
+    icalcomponent *ical = e_cal_component_get_icalcomponent(comp);
+    if (!hasRecurrence(comp) || (RecurrenceCache::recurrencePropertiesCount(ical) == 0)) {
+        return false;
     }
 
-    return journal;
+    const char *uid = icalcomponent_get_uid(ical);
+    key->uid = QByteArray::fromRawData(uid, uid ? qstrlen(uid) : 0);
+    key->sequence = icalcomponent_get_sequence(ical);
+    key->lastModified = 0;
+    icalproperty *prop = icalcomponent_get_first_property(ical, ICAL_LASTMODIFIED_PROPERTY);
+    if (prop) {
+        key->lastModified = icaltime_as_timet(icalproperty_get_lastmodified(prop));
+    }
+    return true;
 }
 
 void QOrganizerEDSEngine::parseSummary(ECalComponent *comp, QtOrganizer::QOrganizerItem *item)
@@ -1905,7 +2637,7 @@ void QOrganizerEDSEngine::parseTags(ECalComponent *comp, QtOrganizer::QOrganizer
     GSList *categories = 0;
     e_cal_component_get_categories_list(comp, &categories);
     for(GSList *tag=categories; tag != 0; tag = tag->next) {
-        item->addTag(QString::fromUtf8(static_cast<gchar*>(tag->data)));
+        item->addTag(StringPool::instance()->intern(static_cast<gchar*>(tag->data)));
     }
     e_cal_component_free_categories_list(categories);
 }
@@ -1949,7 +2681,7 @@ void QOrganizerEDSEngine::parseAudibleReminderAttachment(ECalComponentAlarm *ala
 
 void QOrganizerEDSEngine::parseReminders(ECalComponent *comp,
                                          QtOrganizer::QOrganizerItem *item,
-                                         QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint)
+                                         DetailsMask mask)
 {
     GList *alarms = e_cal_component_get_alarm_uids(comp);
     for(GList *a = alarms; a != 0; a = a->next) {
@@ -1966,23 +2698,20 @@ void QOrganizerEDSEngine::parseReminders(ECalComponent *comp,
         switch(aAction)
         {
             case E_CAL_COMPONENT_ALARM_DISPLAY:
-                if (!detailsHint.isEmpty() &&
-                    !detailsHint.contains(QOrganizerItemDetail::TypeReminder) &&
-                    !detailsHint.contains(QOrganizerItemDetail::TypeVisualReminder)) {
+                if (!(mask & (detailBit(QOrganizerItemDetail::TypeReminder) |
+                              detailBit(QOrganizerItemDetail::TypeVisualReminder)))) {
                     continue;
                 }
                 aDetail = new QOrganizerItemVisualReminder();
                 parseVisualReminderAttachment(alarm.data(), aDetail);
                 break;
             case E_CAL_COMPONENT_ALARM_AUDIO:
-                if (!detailsHint.isEmpty() &&
-                    !detailsHint.contains(QOrganizerItemDetail::TypeReminder) &&
-                    !detailsHint.contains(QOrganizerItemDetail::TypeAudibleReminder)) {
-                    continue;
-                }
-
             // use audio as fallback
             default:
+                if (!(mask & (detailBit(QOrganizerItemDetail::TypeReminder) |
+                              detailBit(QOrganizerItemDetail::TypeAudibleReminder)))) {
+                    continue;
+                }
                 aDetail = new QOrganizerItemAudibleReminder();
                 parseAudibleReminderAttachment(alarm.data(), aDetail);
                 break;
@@ -2031,32 +2760,41 @@ void QOrganizerEDSEngine::parseEventsAsync(const QMap<QString, GSList *> &events
                                            bool isIcalEvents,
                                            QList<QOrganizerItemDetail::DetailType> detailsHint,
                                            QObject *source,
-                                           const QByteArray &slot)
+                                           const QByteArray &slot,
+                                           const QMap<QString, QList<SeriesExpansion*> > &expansions)
 {
+    // the thread takes the ownership of the lists and the expansions
     QMap<QOrganizerEDSCollectionEngineId*, GSList*> request;
     Q_FOREACH(const QString &collectionId, events.keys()) {
         QOrganizerEDSCollectionEngineId *collection = d->m_sourceRegistry->collectionEngineId(collectionId);
-        if (isIcalEvents) {
-            request.insert(collection,
-                           g_slist_copy_deep(events.value(collectionId),
-                                             (GCopyFunc) icalcomponent_new_clone, NULL));
-        } else {
-            request.insert(collection,
-                           g_slist_copy_deep(events.value(collectionId),
-                                             (GCopyFunc) g_object_ref, NULL));
-        }
+        request.insert(collection, events.value(collectionId));
+    }
+
+    QMap<QOrganizerEDSCollectionEngineId*, QList<SeriesExpansion*> > expansionsRequest;
+    Q_FOREACH(const QString &collectionId, expansions.keys()) {
+        QOrganizerEDSCollectionEngineId *collection = d->m_sourceRegistry->collectionEngineId(collectionId);
+        expansionsRequest.insert(collection, expansions.value(collectionId));
     }
 
-    // the thread will destroy itself when done
+    // the pool will destroy it when done
     QOrganizerParseEventThread *thread = new QOrganizerParseEventThread(source, slot);
-    thread->start(request, isIcalEvents, detailsHint);
+    thread->start(request, isIcalEvents, detailsHint, expansionsRequest);
 }
 
 QList<QOrganizerItem> QOrganizerEDSEngine::parseEvents(QOrganizerEDSCollectionEngineId *collectionId, GSList *events, bool isIcalEvents, QList<QOrganizerItemDetail::DetailType> detailsHint)
 {
+    return parseEvents(collectionId, events, isIcalEvents, detailsMask(detailsHint));
+}
+
+QList<QOrganizerItem> QOrganizerEDSEngine::parseEvents(QOrganizerEDSCollectionEngineId *collectionId, GSList *events, bool isIcalEvents, DetailsMask detailsMask)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
     QList<QOrganizerItem> items;
+    // first occurrence parsed of each series, used by the following ones
+    QHash<SeriesKey, QOrganizerItem> series;
     for (GSList *l = events; l; l = l->next) {
-        QOrganizerItem *item;
+        QOrganizerItem item;
         ECalComponent *comp;
         if (isIcalEvents) {
             icalcomponent *clone = icalcomponent_new_clone(static_cast<icalcomponent*>(l->data));
@@ -2070,74 +2808,117 @@ QList<QOrganizerItem> QOrganizerEDSEngine::parseEvents(QOrganizerEDSCollectionEn
             comp = E_CAL_COMPONENT(l->data);
         }
 
-        //type
-        ECalComponentVType vType = e_cal_component_get_vtype(comp);
-        switch(vType) {
-            case E_CAL_COMPONENT_EVENT:
-                item = parseEvent(comp, detailsHint);
-                break;
-            case E_CAL_COMPONENT_TODO:
-                item = parseToDo(comp, detailsHint);
-                break;
-            case E_CAL_COMPONENT_JOURNAL:
-                item = parseJournal(comp, detailsHint);
-                break;
-            case E_CAL_COMPONENT_FREEBUSY:
-                qWarning() << "Component FREEBUSY not supported;";
-                continue;
-            case E_CAL_COMPONENT_TIMEZONE:
-                qWarning() << "Component TIMEZONE not supported;";
-            case E_CAL_COMPONENT_NO_TYPE:
-                continue;
-        }
-        // id is mandatory
-        parseId(comp, item, collectionId);
-
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeDescription)) {
-            parseDescription(comp, item);
-        }
-
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeDisplayLabel)) {
-            parseSummary(comp, item);
+        if (parseItem(comp, collectionId, detailsMask, &series, &item)) {
+            items << item;
         }
 
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeComment)) {
-            parseComments(comp, item);
-        }
-
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeTag)) {
-            parseTags(comp, item);
+        if (isIcalEvents) {
+            g_object_unref(comp);
         }
+    }
+    EngineMetrics::instance()->addParse(items.size(), elapsed.nsecsElapsed() / 1000);
+    return items;
+}
 
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeReminder) ||
-            detailsHint.contains(QOrganizerItemDetail::TypeVisualReminder) ||
-            detailsHint.contains(QOrganizerItemDetail::TypeAudibleReminder) ||
-            detailsHint.contains(QOrganizerItemDetail::TypeEmailReminder)) {
-            parseReminders(comp, item, detailsHint);
-        }
+bool QOrganizerEDSEngine::parseItem(ECalComponent *comp,
+                                    QOrganizerEDSCollectionEngineId *collectionId,
+                                    DetailsMask detailsMask,
+                                    QHash<SeriesKey, QOrganizerItem> *series,
+                                    QOrganizerItem *item)
+{
+    SeriesKey key;
+    bool isSeries = seriesKey(comp, &key);
+    QHash<SeriesKey, QOrganizerItem>::const_iterator seriesItem = series->constEnd();
+    if (isSeries) {
+        seriesItem = series->constFind(key);
+    }
 
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeEventAttendee)) {
-            parseAttendeeList(comp, item);
+    //type
+    ECalComponentVType vType = e_cal_component_get_vtype(comp);
+    switch(vType) {
+        case E_CAL_COMPONENT_EVENT:
+            *item = (seriesItem != series->constEnd()) ?
+                    parseOccurrence<E_CAL_COMPONENT_EVENT>(comp, seriesItem.value(), collectionId, detailsMask) :
+                    parseComponent<E_CAL_COMPONENT_EVENT>(comp, collectionId, detailsMask);
+            break;
+        case E_CAL_COMPONENT_TODO:
+            *item = (seriesItem != series->constEnd()) ?
+                    parseOccurrence<E_CAL_COMPONENT_TODO>(comp, seriesItem.value(), collectionId, detailsMask) :
+                    parseComponent<E_CAL_COMPONENT_TODO>(comp, collectionId, detailsMask);
+            break;
+        case E_CAL_COMPONENT_JOURNAL:
+            *item = (seriesItem != series->constEnd()) ?
+                    parseOccurrence<E_CAL_COMPONENT_JOURNAL>(comp, seriesItem.value(), collectionId, detailsMask) :
+                    parseComponent<E_CAL_COMPONENT_JOURNAL>(comp, collectionId, detailsMask);
+            break;
+        case E_CAL_COMPONENT_FREEBUSY:
+            qWarning() << "Component FREEBUSY not supported;";
+            return false;
+        case E_CAL_COMPONENT_TIMEZONE:
+            qWarning() << "Component TIMEZONE not supported;";
+        case E_CAL_COMPONENT_NO_TYPE:
+            return false;
+    }
+    if (seriesItem == series->constEnd()) {
+        runConverters(m_commonConverters, comp, item, detailsMask);
+        if (isSeries) {
+            // the stored key outlives the component, keep a copy of the uid
+            key.uid = QByteArray(key.uid.constData(), key.uid.size());
+            series->insert(key, *item);
         }
+    }
+    return true;
+}
 
-        if (detailsHint.isEmpty() ||
-            detailsHint.contains(QOrganizerItemDetail::TypeExtendedDetail)) {
-            parseExtendedDetails(comp, item);
-        }
+QList<QOrganizerItem> QOrganizerEDSEngine::parseExpansions(QOrganizerEDSCollectionEngineId *collectionId,
+                                                           const QList<SeriesExpansion*> &expansions,
+                                                           DetailsMask detailsMask)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QList<QOrganizerItem> items;
+    QHash<SeriesKey, QOrganizerItem> series;
+    Q_FOREACH(SeriesExpansion *expansion, expansions) {
+        ECalComponent *comp = expansion->master();
+        bool isTodo = (e_cal_component_get_vtype(comp) == E_CAL_COMPONENT_TODO);
+        QByteArray tzId = expansion->tzId();
+        bool hasDue = false;
+        if (isTodo) {
+            ECalComponentDateTime due;
+            e_cal_component_get_due(comp, &due);
+            hasDue = (due.value != 0);
+            e_cal_component_free_datetime(&due);
+        }
+
+        // stamp each occurrence on the master, the series details are parsed only once
+        Q_FOREACH(const SeriesExpansion::Occurrence &occurrence, expansion->occurrences()) {
+            struct icaltimetype start = occurrence.start;
+            struct icaltimetype end = occurrence.end;
 
-        items << *item;
-        delete item;
+            ECalComponentDateTime dt;
+            dt.tzid = tzId.isEmpty() ? 0 : tzId.constData();
+            dt.value = &start;
+            e_cal_component_set_dtstart(comp, &dt);
+
+            ECalComponentRange range;
+            range.type = E_CAL_COMPONENT_RANGE_SINGLE;
+            range.datetime = dt;
+            e_cal_component_set_recurid(comp, &range);
+
+            dt.value = &end;
+            if (!isTodo) {
+                e_cal_component_set_dtend(comp, &dt);
+            } else if (hasDue) {
+                e_cal_component_set_due(comp, &dt);
+            }
 
-        if (isIcalEvents) {
-            g_object_unref(comp);
+            QOrganizerItem item;
+            if (parseItem(comp, collectionId, detailsMask, &series, &item)) {
+                items << item;
+            }
         }
     }
+    EngineMetrics::instance()->addParse(items.size(), elapsed.nsecsElapsed() / 1000);
     return items;
 }
 
@@ -2521,11 +3302,9 @@ void QOrganizerEDSEngine::parseId(ECalComponent *comp,
         return;
     }
 
-    edsId = QOrganizerEDSEngineId::fromComponentId(edsCollectionId->m_collectionId, id, &edsParentId);
+    edsId = QOrganizerEDSEngineId::fromComponentId(edsCollectionId, id, &edsParentId);
     item->setId(QOrganizerItemId(edsId));
-    item->setGuid(QString("%1/%2")
-                    .arg(edsCollectionId->m_collectionId)
-                    .arg(edsId->m_itemId));
+    item->setGuid(edsId->toString());
 
     if (edsParentId) {
         QOrganizerItemParent itemParent = item->detail(QOrganizerItemDetail::TypeParent);
@@ -2746,6 +3525,9 @@ GSList *QOrganizerEDSEngine::parseItems(ECalClient *client,
                                         bool *hasRecurrence)
 {
     GSList *comps = 0;
+    // ECalComponent does not free an icalcomponent which has a parent, we use
+    // this to take the icalcomponent out of the ECalComponent without cloning it
+    icalcomponent *holder = icalcomponent_new(ICAL_VCALENDAR_COMPONENT);
 
     Q_FOREACH(const QOrganizerItem &item, items) {
         ECalComponent *comp = 0;
@@ -2785,13 +3567,16 @@ GSList *QOrganizerEDSEngine::parseItems(ECalClient *client,
             e_cal_component_abort_sequence(comp);
         }
 
-        comps = g_slist_append(comps,
-                               icalcomponent_new_clone(e_cal_component_get_icalcomponent(comp)));
-
+        icalcomponent *icalComp = e_cal_component_get_icalcomponent(comp);
+        icalcomponent_add_component(holder, icalComp);
         g_object_unref(comp);
+        icalcomponent_remove_component(holder, icalComp);
+
+        comps = g_slist_prepend(comps, icalComp);
     }
 
-    return comps;
+    icalcomponent_free(holder);
+    return g_slist_reverse(comps);
 }
 
 void QOrganizerEDSEngine::parseId(const QOrganizerItem &item, ECalComponent *comp)
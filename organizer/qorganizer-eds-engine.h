@@ -20,8 +20,10 @@
 #define QORGANIZER_EDS_ENGINE_H
 
 #include "qorganizer-eds-collection-engineid.h"
+#include "qorganizer-eds-requeststats.h"
 
 #include <QExplicitlySharedDataPointer>
+#include <QIODevice>
 
 #include <QtOrganizer/QOrganizerItemId>
 #include <QtOrganizer/QOrganizerItemFetchHint>
@@ -32,10 +34,15 @@
 #include <QtOrganizer/QOrganizerItemChangeSet>
 #include <QtOrganizer/QOrganizerCollectionId>
 #include <QtOrganizer/QOrganizerItemReminder>
+#include <QtOrganizer/QOrganizerItemRecurrence>
 #include <QtOrganizer/QOrganizerItemOccurrenceFetchRequest>
 
 #include <libecal/libecal.h>
 
+// manager parameter with the file used to keep the collections between
+// runs, the first collection requests are answered from it
+#define WARM_START_CACHE_PARAMETER "warm-start-cache"
+
 class RequestData;
 class FetchRequestData;
 class FetchByIdRequestData;
@@ -45,9 +52,11 @@ class RemoveRequestData;
 class RemoveByIdRequestData;
 class SaveCollectionRequestData;
 class RemoveCollectionRequestData;
+struct RemoveCollectionOperation;
 class ViewWatcher;
 class QOrganizerEDSEngineData;
 class QOrganizerEDSCollectionEngineId;
+class SeriesExpansion;
 
 class QOrganizerEDSEngine : public QtOrganizer::QOrganizerManagerEngine
 {
@@ -97,6 +106,38 @@ public:
                                                        const QtOrganizer::QOrganizerItemFetchHint &fetchHint,
                                                        QtOrganizer::QOrganizerManager::Error *error);
 
+    // alarm triggers inside [startDateTime, endDateTime), sorted by trigger time
+    QList<QPair<QtOrganizer::QOrganizerItemId, QDateTime> > upcomingAlarms(const QDateTime &startDateTime,
+                                                                          const QDateTime &endDateTime);
+
+    // merged busy time of the given collections (all of them if empty) inside [startDateTime, endDateTime)
+    QList<QPair<QDateTime, QDateTime> > busyIntervals(const QDateTime &startDateTime,
+                                                      const QDateTime &endDateTime,
+                                                      const QList<QtOrganizer::QOrganizerCollectionId> &collectionIds,
+                                                      QtOrganizer::QOrganizerManager::Error *error);
+
+    // streams the iCalendar data of the given collections (all of them if empty) to the device
+    bool exportItems(QIODevice *device,
+                     const QList<QtOrganizer::QOrganizerCollectionId> &collectionIds,
+                     QtOrganizer::QOrganizerManager::Error *error);
+
+    // creates the components of an iCalendar stream in the collection (the default one if null),
+    // errorMap uses the index of the component in the stream ignoring VTIMEZONEs
+    bool importItems(QIODevice *device,
+                     const QtOrganizer::QOrganizerCollectionId &collectionId,
+                     QMap<int, QtOrganizer::QOrganizerManager::Error> *errorMap,
+                     QtOrganizer::QOrganizerManager::Error *error);
+
+    // ids changed in the collection since the backend revision, currentRevision is
+    // always set; DoesNotExistError means the revision is unknown and a full fetch is needed
+    bool itemChangesSince(const QtOrganizer::QOrganizerCollectionId &collectionId,
+                          const QString &revision,
+                          QList<QtOrganizer::QOrganizerItemId> *addedIds,
+                          QList<QtOrganizer::QOrganizerItemId> *changedIds,
+                          QList<QtOrganizer::QOrganizerItemId> *removedIds,
+                          QString *currentRevision,
+                          QtOrganizer::QOrganizerManager::Error *error);
+
     bool saveItems(QList<QtOrganizer::QOrganizerItem> *items,
                    const QList<QtOrganizer::QOrganizerItemDetail::DetailType> &detailMask,
                    QMap<int, QtOrganizer::QOrganizerManager::Error> *errorMap,
@@ -111,6 +152,8 @@ public:
     QtOrganizer::QOrganizerCollection collection(const QtOrganizer::QOrganizerCollectionId &collectionId,
                                                   QtOrganizer::QOrganizerManager::Error *error);
     QList<QtOrganizer::QOrganizerCollection> collections(QtOrganizer::QOrganizerManager::Error* error);
+    // changes whenever a collection is added, removed or updated
+    quint64 collectionsGeneration() const;
     bool saveCollection(QtOrganizer::QOrganizerCollection* collection, QtOrganizer::QOrganizerManager::Error* error);
     bool removeCollection(const QtOrganizer::QOrganizerCollectionId& collectionId, QtOrganizer::QOrganizerManager::Error* error);
 
@@ -127,9 +170,17 @@ public:
 
     // debug
     int runningRequestCount() const;
+    // timings of the last finished requests, oldest first
+    QList<RequestStats> requestStats() const;
+    // aggregated metrics of the process, in the same form as managerParameters
+    QMap<QString, QString> metrics() const;
+
+Q_SIGNALS:
+    void exportProgress(const QtOrganizer::QOrganizerCollectionId &collectionId, int exportedCount);
 
 protected Q_SLOTS:
     void onSourceAdded(const QString &collectionId);
+    void onSourceRegistryLoaded();
     void onSourceRemoved(const QString &collectionId);
     void onSourceUpdated(const QString &collectionId);
     void onViewChanged(QtOrganizer::QOrganizerItemChangeSet *change);
@@ -141,14 +192,70 @@ private:
     static QOrganizerEDSEngineData *m_globalData;
     QOrganizerEDSEngineData *d;
     QMap<QtOrganizer::QOrganizerAbstractRequest*, RequestData*> m_runningRequests;
+    // requests started before the source registry was loaded
+    QList<QtOrganizer::QOrganizerAbstractRequest*> m_pendingRequests;
+
+    // the details hint is compiled once per request into a mask with one bit per detail type
+    typedef quint32 DetailsMask;
+    static Q_DECL_CONSTEXPR DetailsMask detailBit(QtOrganizer::QOrganizerItemDetail::DetailType type)
+    {
+        return (type / 100) < 32 ? (1u << (type / 100)) : 0u;
+    }
+    static DetailsMask detailsMask(const QList<QtOrganizer::QOrganizerItemDetail::DetailType> &detailsHint);
+
+    typedef void (*DetailConverter)(ECalComponent *comp, QtOrganizer::QOrganizerItem *item, DetailsMask mask);
+    struct DetailConverterEntry
+    {
+        DetailsMask mask;
+        DetailConverter convert;
+    };
+    static const DetailConverterEntry m_commonConverters[];
+    template<void (*Parser)(ECalComponent *, QtOrganizer::QOrganizerItem *)>
+    static void convertDetail(ECalComponent *comp, QtOrganizer::QOrganizerItem *item, DetailsMask mask);
+    static void runConverters(const DetailConverterEntry *converters, ECalComponent *comp, QtOrganizer::QOrganizerItem *item, DetailsMask mask);
+    template<ECalComponentVType VType> struct ComponentConverters;
+    template<ECalComponentVType VType>
+    static QtOrganizer::QOrganizerItem parseComponent(ECalComponent *comp, QOrganizerEDSCollectionEngineId *collectionId, DetailsMask mask);
+    // occurrences generated from the same series only differ on id and time details
+    template<ECalComponentVType VType>
+    static QtOrganizer::QOrganizerItem parseOccurrence(ECalComponent *comp, const QtOrganizer::QOrganizerItem &series, QOrganizerEDSCollectionEngineId *collectionId, DetailsMask mask);
+    // version of a series, occurrences parsed from the same version share the series details
+    struct SeriesKey
+    {
+        QByteArray uid;
+        int sequence;
+        time_t lastModified;
+
+        bool operator==(const SeriesKey &other) const
+        {
+            return (sequence == other.sequence) &&
+                   (lastModified == other.lastModified) &&
+                   (uid == other.uid);
+        }
+        friend uint qHash(const SeriesKey &key, uint seed = 0)
+        {
+            return qHash(key.uid, seed) ^ uint(key.sequence) ^ qHash(qint64(key.lastModified), seed);
+        }
+    };
+    // the key uid points to the component data, it must not outlive the component
+    static bool seriesKey(ECalComponent *comp, SeriesKey *key);
 
     QList<QtOrganizer::QOrganizerItem> parseEvents(const QString &collectionId, GSList *events, bool isIcalEvents, QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint);
+    // the parse thread takes the ownership of the event lists and the expansions
     void parseEventsAsync(const QMap<QString, GSList *> &events,
                           bool isIcalEvents,
                           QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint,
                           QObject *source,
-                          const QByteArray &slot);
+                          const QByteArray &slot,
+                          const QMap<QString, QList<SeriesExpansion*> > &expansions = QMap<QString, QList<SeriesExpansion*> >());
     static QList<QtOrganizer::QOrganizerItem> parseEvents(QOrganizerEDSCollectionEngineId *collectionId, GSList *events, bool isIcalEvents, QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint);
+    static QList<QtOrganizer::QOrganizerItem> parseEvents(QOrganizerEDSCollectionEngineId *collectionId, GSList *events, bool isIcalEvents, DetailsMask detailsMask);
+    static QList<QtOrganizer::QOrganizerItem> parseExpansions(QOrganizerEDSCollectionEngineId *collectionId, const QList<SeriesExpansion*> &expansions, DetailsMask detailsMask);
+    static bool parseItem(ECalComponent *comp,
+                          QOrganizerEDSCollectionEngineId *collectionId,
+                          DetailsMask detailsMask,
+                          QHash<SeriesKey, QtOrganizer::QOrganizerItem> *series,
+                          QtOrganizer::QOrganizerItem *item);
     static GSList *parseItems(ECalClient *client, QList<QtOrganizer::QOrganizerItem> items, bool *hasRecurrence);
 
     // QOrganizerItem -> ECalComponent
@@ -183,7 +290,7 @@ private:
     static void parseDescription(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseComments(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseTags(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
-    static void parseReminders(ECalComponent *comp, QtOrganizer::QOrganizerItem *item, QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint = QList<QtOrganizer::QOrganizerItemDetail::DetailType>());
+    static void parseReminders(ECalComponent *comp, QtOrganizer::QOrganizerItem *item, DetailsMask mask = ~DetailsMask(0));
     static QUrl dencodeAttachment(ECalComponentAlarm *alarm);
     static void parseAudibleReminderAttachment(ECalComponentAlarm *alarm, QtOrganizer::QOrganizerItemReminder *aDetail);
     static void parseVisualReminderAttachment(ECalComponentAlarm *alarm, QtOrganizer::QOrganizerItemReminder *aDetail);
@@ -191,12 +298,14 @@ private:
     static void parseTodoStartTime(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseEndTime(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseRecurrence(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
+    static void parseRecurrenceDetail(ECalComponent *comp, QtOrganizer::QOrganizerItemRecurrence *rec);
     static void parseWeekRecurrence(struct icalrecurrencetype *rule, QtOrganizer::QOrganizerRecurrenceRule *qRule);
     static void parseMonthRecurrence(struct icalrecurrencetype *rule, QtOrganizer::QOrganizerRecurrenceRule *qRule);
     static void parseYearRecurrence(struct icalrecurrencetype *rule, QtOrganizer::QOrganizerRecurrenceRule *qRule);
     static void parsePriority(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseLocation(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseDueDate(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
+    static void parseJournalTime(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseProgress(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseStatus(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
     static void parseAttendeeList(ECalComponent *comp, QtOrganizer::QOrganizerItem *item);
@@ -205,10 +314,6 @@ private:
     static QDateTime fromIcalTime(struct icaltimetype value, const char *tzId);
     static icaltimetype fromQDateTime(const QDateTime &dateTime, bool allDay, QByteArray *tzId);
 
-    static QtOrganizer::QOrganizerItem *parseEvent(ECalComponent *comp, QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint);
-    static QtOrganizer::QOrganizerItem *parseToDo(ECalComponent *comp, QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint);
-    static QtOrganizer::QOrganizerItem *parseJournal(ECalComponent *comp, QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint);
-
     static ECalComponent *createDefaultComponent(ECalClient *client, icalcomponent_kind iKind, ECalComponentVType eType);
     static ECalComponent *parseEventItem(ECalClient *client, const QtOrganizer::QOrganizerItem &item);
     static ECalComponent *parseTodoItem(ECalClient *client, const QtOrganizer::QOrganizerItem &item);
@@ -220,8 +325,14 @@ private:
     static gboolean itemsAsyncListed(ECalComponent *comp, time_t instanceStart, time_t instanceEnd, FetchRequestData *data);
     static void itemsAsyncDone(FetchRequestData *data);
     static void itemsAsyncListedAsComps(GObject *source, GAsyncResult *res, FetchRequestData *data);
+    static void itemsAsyncExpandListed(GObject *source, GAsyncResult *res, FetchRequestData *data);
+    static void itemsAsyncExpandExceptionsListed(GObject *source, GAsyncResult *res, FetchRequestData *data);
+    static void itemsAsyncExpand(FetchRequestData *data);
     static void itemsAsyncFetchDeatachedItems(FetchRequestData *data);
     static void itemsAsyncListByIdListed(GObject *source, GAsyncResult *res, FetchRequestData *data);
+    static void itemsAsyncViewReady(GObject *source, GAsyncResult *res, FetchRequestData *data);
+    static void itemsAsyncViewObjectsAdded(ECalClientView *view, GSList *objects, FetchRequestData *data);
+    static void itemsAsyncViewComplete(ECalClientView *view, const GError *error, FetchRequestData *data);
 
     void itemsByIdAsync(QtOrganizer::QOrganizerItemFetchByIdRequest *req);
     static void itemsByIdAsyncStart(FetchByIdRequestData *data);
@@ -249,7 +360,12 @@ private:
     static void saveCollectionUpdateAsynCommited(ESource *source, GAsyncResult *res, SaveCollectionRequestData *data);
 
     void removeCollectionAsync(QtOrganizer::QOrganizerCollectionRemoveRequest *req);
-    static void removeCollectionAsyncStart(GObject *sourceObject, GAsyncResult *res, RemoveCollectionRequestData *data);
+    static void removeCollectionAsyncStart(RemoveCollectionRequestData *data);
+    static void removeCollectionAsyncRemove(RemoveCollectionOperation *op);
+    static void removeCollectionAsyncSourceChanged(ESource *source, GParamSpec *pspec, RemoveCollectionOperation *op);
+    static gboolean removeCollectionAsyncTimeout(RemoveCollectionOperation *op);
+    static void removeCollectionAsyncRemoved(GObject *sourceObject, GAsyncResult *res, RemoveCollectionOperation *op);
+    static void removeCollectionAsyncDone(RemoveCollectionOperation *op);
 
     static void releaseRequestData(RequestData *data);
 
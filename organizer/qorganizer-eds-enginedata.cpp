@@ -19,15 +19,24 @@
 #include "qorganizer-eds-enginedata.h"
 #include "qorganizer-eds-viewwatcher.h"
 #include "qorganizer-eds-source-registry.h"
+#include "qorganizer-eds-alarmindex.h"
+#include "qorganizer-eds-changejournal.h"
+#include "qorganizer-eds-requeststats.h"
 
 QOrganizerEDSEngineData::QOrganizerEDSEngineData()
     : QSharedData(),
       m_sourceRegistry(0)
 {
+    m_alarmIndex = new AlarmIndex(this);
+    m_changeJournal = new ChangeJournal;
+    m_requestStats = new RequestStatsLog;
 }
 
 QOrganizerEDSEngineData::QOrganizerEDSEngineData(const QOrganizerEDSEngineData& other)
-    : QSharedData(other)
+    : QSharedData(other),
+      m_alarmIndex(0),
+      m_changeJournal(0),
+      m_requestStats(0)
 {
 }
 
@@ -36,6 +45,15 @@ QOrganizerEDSEngineData::~QOrganizerEDSEngineData()
     qDeleteAll(m_viewWatchers);
     m_viewWatchers.clear();
 
+    delete m_alarmIndex;
+    m_alarmIndex = 0;
+
+    delete m_changeJournal;
+    m_changeJournal = 0;
+
+    delete m_requestStats;
+    m_requestStats = 0;
+
     if (m_sourceRegistry) {
         m_sourceRegistry->deleteLater();
         m_sourceRegistry = 0;
@@ -54,10 +72,17 @@ ViewWatcher* QOrganizerEDSEngineData::watch(const QString &collectionId)
     return vw;
 }
 
+ViewWatcher* QOrganizerEDSEngineData::watcher(const QString &collectionId) const
+{
+    return m_viewWatchers.value(collectionId);
+}
+
 void QOrganizerEDSEngineData::unWatch(const QString &collectionId)
 {
     ViewWatcher *viewW = m_viewWatchers.take(collectionId);
     if (viewW) {
         delete viewW;
     }
+    m_alarmIndex->removeCollection(collectionId);
+    m_changeJournal->removeCollection(collectionId);
 }
@@ -28,6 +28,9 @@
 #include <QtOrganizer/QOrganizerCollectionChangeSet>
 
 class SourceRegistry;
+class AlarmIndex;
+class ChangeJournal;
+class RequestStatsLog;
 class ViewWatcher;
 class RequestData;
 
@@ -47,10 +50,14 @@ public:
     }
 
     ViewWatcher* watch(const QString &collectionId);
+    ViewWatcher* watcher(const QString &collectionId) const;
     void unWatch(const QString &collectionId);
 
     QAtomicInt m_refCount;
     SourceRegistry *m_sourceRegistry;
+    AlarmIndex *m_alarmIndex;
+    ChangeJournal *m_changeJournal;
+    RequestStatsLog *m_requestStats;
     QSet<QtOrganizer::QOrganizerManagerEngine*> m_sharedEngines;
 
 private:
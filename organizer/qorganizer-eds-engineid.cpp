@@ -17,28 +17,58 @@
  */
 
 #include "qorganizer-eds-engineid.h"
+#include "qorganizer-eds-stringpool.h"
 
-#include <QtCore/QStringList>
 #include <QtCore/QDebug>
 
 using namespace QtOrganizer;
 
+// drops the manager uri prefix if any, and returns the shared copy of the value
+static QString internId(const QString &value)
+{
+    int start = value.lastIndexOf(':') + 1;
+    if (start) {
+        return StringPool::instance()->intern(value.midRef(start));
+    }
+    return StringPool::instance()->intern(value);
+}
+
 QOrganizerEDSEngineId::QOrganizerEDSEngineId()
     : QOrganizerItemEngineId()
 {
+    init(QString(), QString(), QString());
 }
 
 QOrganizerEDSEngineId::QOrganizerEDSEngineId(const QString &collectionId,
                                              const QString &id)
     : QOrganizerItemEngineId()
 {
-    if (!collectionId.isNull() && !collectionId.isEmpty()) {
-        m_collectionId = collectionId.contains(":") ? collectionId.mid(collectionId.lastIndexOf(":")+1) : collectionId;
+    StringPool *pool = StringPool::instance();
+    int start = id.lastIndexOf(':') + 1;
+    int ridIndex = id.indexOf('#', start);
+    if (ridIndex < 0) {
+        init(internId(collectionId), pool->intern(id.midRef(start)), QString());
+    } else {
+        init(internId(collectionId),
+             pool->intern(id.midRef(start, ridIndex - start)),
+             id.mid(ridIndex + 1));
     }
+}
 
-    if (!id.isNull() && !id.isEmpty()) {
-        m_itemId = id.contains(":") ? id.mid(id.lastIndexOf(":")+1) : id;
-    }
+QOrganizerEDSEngineId::QOrganizerEDSEngineId(const QString &collectionId,
+                                             const QString &uid,
+                                             const QString &rid)
+    : QOrganizerItemEngineId()
+{
+    init(internId(collectionId), internId(uid), rid);
+}
+
+QOrganizerEDSEngineId::QOrganizerEDSEngineId(const QOrganizerEDSCollectionEngineId *collectionId,
+                                             const QString &uid,
+                                             const QString &rid)
+    : QOrganizerItemEngineId()
+{
+    init(collectionId->m_collectionId, uid, rid);
 }
 
 QOrganizerEDSEngineId::~QOrganizerEDSEngineId()
@@ -48,18 +78,59 @@ QOrganizerEDSEngineId::~QOrganizerEDSEngineId()
 QOrganizerEDSEngineId::QOrganizerEDSEngineId(const QOrganizerEDSEngineId& other)
     : QOrganizerItemEngineId(),
       m_collectionId(other.m_collectionId),
-      m_itemId(other.m_itemId)
+      m_uid(other.m_uid),
+      m_rid(other.m_rid),
+      m_idString(other.m_idString),
+      m_hash(other.m_hash)
 {
 }
 
 QOrganizerEDSEngineId::QOrganizerEDSEngineId(const QString& idString)
     : QOrganizerItemEngineId()
 {
-    QString edsIdPart = idString.contains(":") ? idString.mid(idString.lastIndexOf(":")+1) : idString;
-    QStringList idParts = edsIdPart.split("/");
-    Q_ASSERT(idParts.count() == 2);
-    m_collectionId = idParts.first();
-    m_itemId = idParts.last();
+    StringPool *pool = StringPool::instance();
+    int start = idString.lastIndexOf(':') + 1;
+    int slash = idString.indexOf('/', start);
+    Q_ASSERT(slash > 0);
+    if (slash < 0) {
+        init(pool->intern(idString.midRef(start)), QString(), QString());
+        return;
+    }
+    int ridIndex = idString.indexOf('#', slash + 1);
+    if (ridIndex < 0) {
+        init(pool->intern(idString.midRef(start, slash - start)),
+             pool->intern(idString.midRef(slash + 1)),
+             QString());
+    } else {
+        init(pool->intern(idString.midRef(start, slash - start)),
+             pool->intern(idString.midRef(slash + 1, ridIndex - slash - 1)),
+             idString.mid(ridIndex + 1));
+    }
+}
+
+void QOrganizerEDSEngineId::init(const QString &collectionId,
+                                 const QString &uid,
+                                 const QString &rid)
+{
+    m_collectionId = collectionId;
+    m_uid = uid;
+    m_rid = rid;
+
+    m_idString.reserve(m_collectionId.size() + m_uid.size() + m_rid.size() + 2);
+    m_idString.append(m_collectionId);
+    m_idString.append(QLatin1Char('/'));
+    m_idString.append(m_uid);
+    if (!m_rid.isEmpty()) {
+        m_idString.append(QLatin1Char('#'));
+        m_idString.append(m_rid);
+    }
+    m_hash = qHash(itemIdRef());
+}
+
+QStringRef QOrganizerEDSEngineId::itemIdRef() const
+{
+    // "uid[#rid]" part of the id string
+    return m_idString.midRef(m_collectionId.size() + 1);
 }
 
 bool QOrganizerEDSEngineId::isEqualTo(const QOrganizerItemEngineId* other) const
@@ -68,9 +139,10 @@ bool QOrganizerEDSEngineId::isEqualTo(const QOrganizerItemEngineId* other) const
     // engine are unique regardless of which collection the item is in; also, we
     // don't need to check the managerUri, because this function is not called if
     // the managerUris don't match.
-    if (m_itemId != static_cast<const QOrganizerEDSEngineId*>(other)->m_itemId)
+    const QOrganizerEDSEngineId* otherPtr = static_cast<const QOrganizerEDSEngineId*>(other);
+    if (m_hash != otherPtr->m_hash)
         return false;
-    return true;
+    return (itemIdRef() == otherPtr->itemIdRef());
 }
 
 bool QOrganizerEDSEngineId::isLessThan(const QOrganizerItemEngineId* other) const
@@ -80,7 +152,7 @@ bool QOrganizerEDSEngineId::isLessThan(const QOrganizerItemEngineId* other) cons
     if (m_collectionId < otherPtr->m_collectionId)
         return true;
     if (m_collectionId == otherPtr->m_collectionId)
-        return (m_itemId < otherPtr->m_itemId);
+        return (QStringRef::compare(itemIdRef(), otherPtr->itemIdRef()) < 0);
     return false;
 }
 
@@ -91,23 +163,38 @@ QString QOrganizerEDSEngineId::managerUri() const
 
 QString QOrganizerEDSEngineId::toString() const
 {
-    return QString("%1/%2").arg(m_collectionId).arg(m_itemId);
+    return m_idString;
 }
 
 QOrganizerItemEngineId* QOrganizerEDSEngineId::clone() const
 {
-    return new QOrganizerEDSEngineId(m_collectionId, m_itemId);
+    return new QOrganizerEDSEngineId(*this);
 }
 
 uint QOrganizerEDSEngineId::hash() const
 {
-    return qHash(m_itemId);
+    return m_hash;
+}
+
+QString QOrganizerEDSEngineId::collectionId() const
+{
+    return m_collectionId;
+}
+
+QString QOrganizerEDSEngineId::uid() const
+{
+    return m_uid;
+}
+
+QString QOrganizerEDSEngineId::rid() const
+{
+    return m_rid;
 }
 
 #ifndef QT_NO_DEBUG_STREAM
 QDebug& QOrganizerEDSEngineId::debugStreamOut(QDebug& dbg) const
 {
-    dbg.nospace() << "QOrganizerEDSEngineId(" << managerNameStatic() << ", " << m_collectionId << ", " << m_itemId << ")";
+    dbg.nospace() << "QOrganizerEDSEngineId(" << managerNameStatic() << ", " << m_collectionId << ", " << itemIdRef() << ")";
     return dbg.maybeSpace();
 }
 #endif
@@ -129,11 +216,43 @@ QString QOrganizerEDSEngineId::toComponentId(const QtOrganizer::QOrganizerItemId
 
 QString QOrganizerEDSEngineId::toComponentId(const QString &itemId, QString *rid)
 {
-    QStringList ids = itemId.split("/").last().split("#");
-    if (ids.size() == 2) {
-        *rid = ids[1];
+    int start = itemId.lastIndexOf('/') + 1;
+    int ridIndex = itemId.indexOf('#', start);
+    if (ridIndex < 0) {
+        return itemId.mid(start);
+    }
+    // ignore malformed rids containing more than one '#'
+    if (itemId.indexOf('#', ridIndex + 1) < 0) {
+        *rid = itemId.mid(ridIndex + 1);
     }
-    return ids[0];
+    return itemId.mid(start, ridIndex - start);
+}
+
+bool QOrganizerEDSEngineId::splitItemId(const QString &itemId,
+                                        QString *collectionId,
+                                        QString *uid,
+                                        QString *rid)
+{
+    // "[manager uri:]collection/uid[#rid]", the collection keeps the manager uri
+    int slash = itemId.indexOf('/');
+    if ((slash < 0) || (itemId.indexOf('/', slash + 1) >= 0)) {
+        return false;
+    }
+
+    if (collectionId) {
+        *collectionId = itemId.left(slash);
+    }
+    if (uid || rid) {
+        QString ridPart;
+        QString uidPart = toComponentId(itemId, &ridPart);
+        if (uid) {
+            *uid = uidPart;
+        }
+        if (rid) {
+            *rid = ridPart;
+        }
+    }
+    return true;
 }
 
 ECalComponentId *QOrganizerEDSEngineId::toComponentIdObject(const QOrganizerItemId &itemId)
@@ -152,17 +271,19 @@ ECalComponentId *QOrganizerEDSEngineId::toComponentIdObject(const QOrganizerItem
     return id;
 }
 
-QOrganizerEDSEngineId *QOrganizerEDSEngineId::fromComponentId(const QString &cId,
+QOrganizerEDSEngineId *QOrganizerEDSEngineId::fromComponentId(const QOrganizerEDSCollectionEngineId *collectionId,
                                                               ECalComponentId *id,
                                                               QOrganizerEDSEngineId **parentId)
 {
-    QString iId = QString::fromUtf8(id->uid);
+    // the collection id is interned once for the whole batch, the uid once
+    // for both the item and its parent
+    const char *uid = id->uid ? strrchr(id->uid, ':') : 0;
+    QString iId = StringPool::instance()->intern(uid ? uid + 1 : id->uid);
     QString rId = QString::fromUtf8(id->rid);
 
     if(!rId.isEmpty()) {
-        *parentId = new QOrganizerEDSEngineId(cId, iId);
-        iId += "#" + rId;
+        *parentId = new QOrganizerEDSEngineId(collectionId, iId, QString());
     }
 
-    return new QOrganizerEDSEngineId(cId, iId);
+    return new QOrganizerEDSEngineId(collectionId, iId, rId);
 }
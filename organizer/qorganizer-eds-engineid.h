@@ -32,6 +32,9 @@ public:
     QOrganizerEDSEngineId();
     QOrganizerEDSEngineId(const QString& collectionId,
                           const QString& id);
+    QOrganizerEDSEngineId(const QString& collectionId,
+                          const QString& uid,
+                          const QString& rid);
     ~QOrganizerEDSEngineId();
     QOrganizerEDSEngineId(const QOrganizerEDSEngineId& other);
     QOrganizerEDSEngineId(const QString& idString);
@@ -45,6 +48,10 @@ public:
     QString toString() const;
     uint hash() const;
 
+    QString collectionId() const;
+    QString uid() const;
+    QString rid() const;
+
 #ifndef QT_NO_DEBUG_STREAM
     QDebug& debugStreamOut(QDebug& dbg) const;
 #endif
@@ -53,15 +60,33 @@ public:
     static QString managerNameStatic();
     static QString toComponentId(const QtOrganizer::QOrganizerItemId &itemId, QString *rid);
     static QString toComponentId(const QString &itemId, QString *rid);
+    static bool splitItemId(const QString &itemId,
+                            QString *collectionId,
+                            QString *uid = 0,
+                            QString *rid = 0);
     static ECalComponentId *toComponentIdObject(const QtOrganizer::QOrganizerItemId &itemId);
-    static QOrganizerEDSEngineId *fromComponentId(const QString &cId,
+    static QOrganizerEDSEngineId *fromComponentId(const QOrganizerEDSCollectionEngineId *collectionId,
                                                   ECalComponentId *id,
                                                   QOrganizerEDSEngineId **parentId);
 
 private:
+    // takes the interned values as they are
+    QOrganizerEDSEngineId(const QOrganizerEDSCollectionEngineId *collectionId,
+                          const QString &uid,
+                          const QString &rid);
+
+    // collection and uid are shared between all ids using the same value
     QString m_collectionId;
-    QString m_itemId;
+    QString m_uid;
+    QString m_rid;
+    // "collection/uid[#rid]" built once, used by toString and hash
+    QString m_idString;
+    uint m_hash;
     friend class QOrganizerEDSEngine;
+
+    // collection and uid must be already interned and without the manager uri prefix
+    void init(const QString &collectionId, const QString &uid, const QString &rid);
+    QStringRef itemIdRef() const;
 };
 
 #endif
@@ -17,6 +17,7 @@
  */
 
 #include "qorganizer-eds-fetchbyidrequestdata.h"
+#include "qorganizer-eds-engineid.h"
 
 #include <QtOrganizer/QOrganizerItemFetchByIdRequest>
 
@@ -52,11 +53,9 @@ QString FetchByIdRequestData::currentId() const
 
 QString FetchByIdRequestData::currentCollectionId() const
 {
-    QString itemId = currentId();
-    if (!itemId.isEmpty()) {
-        return itemId.contains("/") ? itemId.split("/").first() : QString();
-    }
-    return QString();
+    QString collectionId;
+    QOrganizerEDSEngineId::splitItemId(currentId(), &collectionId);
+    return collectionId;
 }
 
 bool FetchByIdRequestData::end() const
@@ -68,11 +67,13 @@ bool FetchByIdRequestData::end() const
 void FetchByIdRequestData::finish(QOrganizerManager::Error error,
                                   QOrganizerAbstractRequest::State state)
 {
+    beginPhase(RequestStats::Delivery);
     QOrganizerManagerEngine::updateItemFetchByIdRequest(request<QOrganizerItemFetchByIdRequest>(),
                                                         m_results,
                                                         error,
                                                         m_errors,
                                                         state);
+    endPhase(RequestStats::Delivery);
     RequestData::finish(error, state);
 }
 
@@ -82,6 +83,7 @@ int FetchByIdRequestData::appendResult(const QOrganizerItem &result)
         m_errors.insert(m_current, QOrganizerManager::DoesNotExistError);
     } else {
         m_results << result;
+        addItemCount(1);
     }
     return m_results.length();
 }
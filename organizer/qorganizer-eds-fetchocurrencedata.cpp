@@ -70,16 +70,21 @@ void FetchOcurrenceData::finish(QOrganizerManager::Error error,
     if (m_components) {
         QOrganizerItemOccurrenceFetchRequest *req = request<QOrganizerItemOccurrenceFetchRequest>();
         QString collectionId = req->parentItem().collectionId().toString();
+        beginPhase(RequestStats::Parse);
         results = parent()->parseEvents(collectionId, m_components, true,
                                         req->fetchHint().detailTypesHint());
+        endPhase(RequestStats::Parse);
+        addItemCount(results.size());
         g_slist_free_full(m_components, (GDestroyNotify)icalcomponent_free);
         m_components = 0;
     }
 
+    beginPhase(RequestStats::Delivery);
     QOrganizerManagerEngine::updateItemOccurrenceFetchRequest(request<QOrganizerItemOccurrenceFetchRequest>(),
                                                               results,
                                                               error,
                                                               state);
+    endPhase(RequestStats::Delivery);
 
     RequestData::finish(error, state);
 }
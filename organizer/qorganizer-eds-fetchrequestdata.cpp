@@ -18,6 +18,7 @@
 
 #include "qorganizer-eds-fetchrequestdata.h"
 #include "qorganizer-eds-engineid.h"
+#include "qorganizer-eds-seriesexpansion.h"
 
 #include <QtCore/QDebug>
 
@@ -33,28 +34,39 @@ FetchRequestData::FetchRequestData(QOrganizerEDSEngine *engine,
                                    QOrganizerAbstractRequest *req)
     : RequestData(engine, req),
       m_parseListener(0),
-      m_currentComponents(0)
+      m_pendingParses(0),
+      m_finishing(false),
+      m_finishError(QOrganizerManager::NoError),
+      m_finishState(QOrganizerAbstractRequest::FinishedState),
+      m_currentComponents(0),
+      m_expansionComponents(0),
+      m_view(0)
 {
     // filter collections related with the query
     m_collections = filterCollections(collections);
+
+    QOrganizerItemFetchRequest *fetchReq = request<QOrganizerItemFetchRequest>();
+    if (fetchReq) {
+        m_summaryFields = summaryFieldsFromHint(fetchReq->fetchHint().detailTypesHint());
+        Q_FOREACH(const QByteArray &field, m_summaryFields) {
+            m_summaryProperties << icalproperty_string_to_kind(field.constData());
+        }
+    }
 }
 
 FetchRequestData::~FetchRequestData()
 {
     delete m_parseListener;
+    clearView();
 
-    Q_FOREACH(GSList *components, m_components.values()) {
-        g_slist_free_full(components, (GDestroyNotify)icalcomponent_free);
-    }
-    m_components.clear();
+    clearCurrentCollection();
+    clearExpansionComponents();
 }
 
 QString FetchRequestData::nextCollection()
 {
-    if (m_currentComponents) {
-        m_components.insert(m_current, m_currentComponents);
-        m_currentComponents = 0;
-    }
+    // parse the collection while the next one is fetched
+    parseCurrentCollection();
     m_current = "";
     setClient(0);
     if (m_collections.size()) {
@@ -106,7 +118,7 @@ time_t FetchRequestData::endDate() const
 
 bool FetchRequestData::hasDateInterval() const
 {
-    if (!filterIsValid()) {
+    if (!filterIsValid() || isFetchForExport()) {
         return false;
     }
 
@@ -116,6 +128,12 @@ bool FetchRequestData::hasDateInterval() const
     return (endDate.isValid() && startDate.isValid());
 }
 
+bool FetchRequestData::isFetchForExport() const
+{
+    QOrganizerItemFetchRequest *req = request<QOrganizerItemFetchRequest>();
+    return req && req->property(FETCH_FOR_EXPORT_PROPERTY).toBool();
+}
+
 bool FetchRequestData::filterIsValid() const
 {
     return (request<QOrganizerItemFetchRequest>()->filter().type() != QOrganizerItemFilter::InvalidFilter);
@@ -124,8 +142,10 @@ bool FetchRequestData::filterIsValid() const
 void FetchRequestData::cancel()
 {
     if (m_parseListener) {
+        // results of the running parse threads are dropped
         delete m_parseListener;
         m_parseListener = 0;
+        m_pendingParses = 0;
     }
     RequestData::cancel();
 }
@@ -143,24 +163,80 @@ void FetchRequestData::compileCurrentIds()
 void FetchRequestData::finish(QOrganizerManager::Error error,
                               QOrganizerAbstractRequest::State state)
 {
-    if (!m_components.isEmpty()) {
-        m_parseListener = new FetchRequestDataParseListener(this,
-                                                            error,
-                                                            state);
-        QOrganizerItemFetchRequest *req =  request<QOrganizerItemFetchRequest>();
-        if (req) {
-            parent()->parseEventsAsync(m_components,
-                                       true,
-                                       req->fetchHint().detailTypesHint(),
-                                       m_parseListener,
-                                       SLOT(onParseDone(QList<QtOrganizer::QOrganizerItem>)));
-
-            return;
-        }
+    if (state == QOrganizerAbstractRequest::CanceledState) {
+        clearCurrentCollection();
+    } else {
+        parseCurrentCollection();
+    }
+
+    if (m_pendingParses > 0) {
+        // the request finishes with the last parse thread
+        m_finishing = true;
+        m_finishError = error;
+        m_finishState = state;
+        return;
     }
     finishContinue(error, state);
 }
 
+void FetchRequestData::parseCurrentCollection()
+{
+    if (!m_currentComponents && m_currentExpansions.isEmpty()) {
+        return;
+    }
+
+    QOrganizerItemFetchRequest *req =  request<QOrganizerItemFetchRequest>();
+    if (!req) {
+        clearCurrentCollection();
+        return;
+    }
+
+    // components were prepended while listed
+    QMap<QString, GSList*> components;
+    if (m_currentComponents) {
+        components.insert(m_current, g_slist_reverse(m_currentComponents));
+        m_currentComponents = 0;
+    }
+    QMap<QString, QList<SeriesExpansion*> > expansions;
+    if (!m_currentExpansions.isEmpty()) {
+        expansions.insert(m_current, m_currentExpansions);
+        m_currentExpansions.clear();
+    }
+
+    if (!m_parseListener) {
+        m_parseListener = new FetchRequestDataParseListener(this);
+    }
+    if (m_pendingParses++ == 0) {
+        beginPhase(RequestStats::Parse);
+    }
+    // the parse thread owns the components and expansions now
+    parent()->parseEventsAsync(components,
+                               true,
+                               req->fetchHint().detailTypesHint(),
+                               m_parseListener,
+                               SLOT(onParseDone(QList<QtOrganizer::QOrganizerItem>)),
+                               expansions);
+}
+
+void FetchRequestData::clearCurrentCollection()
+{
+    g_slist_free_full(m_currentComponents, (GDestroyNotify)icalcomponent_free);
+    m_currentComponents = 0;
+    qDeleteAll(m_currentExpansions);
+    m_currentExpansions.clear();
+}
+
+void FetchRequestData::onParseDone(const QList<QOrganizerItem> &results)
+{
+    appendResults(results);
+    if (--m_pendingParses == 0) {
+        endPhase(RequestStats::Parse);
+    }
+    if (m_finishing && (m_pendingParses == 0)) {
+        finishContinue(m_finishError, m_finishState);
+    }
+}
+
 void FetchRequestData::finishContinue(QOrganizerManager::Error error,
                                       QOrganizerAbstractRequest::State state)
 {
@@ -168,27 +244,68 @@ void FetchRequestData::finishContinue(QOrganizerManager::Error error,
         m_parseListener->deleteLater();
         m_parseListener = 0;
     }
-
-    Q_FOREACH(GSList *components, m_components.values()) {
-        g_slist_free_full(components, (GDestroyNotify)icalcomponent_free);
-    }
-    m_components.clear();
+    m_finishing = false;
 
     QOrganizerItemFetchRequest *req =  request<QOrganizerItemFetchRequest>();
     if (req) {
+        beginPhase(RequestStats::Delivery);
         QOrganizerManagerEngine::updateItemFetchRequest(req,
                                                         m_results,
                                                         error,
                                                         state);
+        endPhase(RequestStats::Delivery);
     }
 
     // TODO: emit changeset???
     RequestData::finish(error, state);
 }
 
+bool FetchRequestData::isLocalExpansion() const
+{
+    QOrganizerItemFetchRequest *req = request<QOrganizerItemFetchRequest>();
+    return req && req->property(LOCAL_EXPANSION_PROPERTY).toBool();
+}
+
+void FetchRequestData::appendExpansion(SeriesExpansion *expansion)
+{
+    if (expansion->occurrences().isEmpty()) {
+        delete expansion;
+    } else {
+        m_currentExpansions << expansion;
+    }
+}
+
+void FetchRequestData::setExpansionComponents(GSList *components)
+{
+    clearExpansionComponents();
+    m_expansionComponents = components;
+}
+
+GSList *FetchRequestData::expansionComponents() const
+{
+    return m_expansionComponents;
+}
+
+void FetchRequestData::appendExpansionException(const QString &key)
+{
+    m_expansionExceptions << key;
+}
+
+const QSet<QString> &FetchRequestData::expansionExceptions() const
+{
+    return m_expansionExceptions;
+}
+
+void FetchRequestData::clearExpansionComponents()
+{
+    e_cal_client_free_ecalcomp_slist(m_expansionComponents);
+    m_expansionComponents = 0;
+    m_expansionExceptions.clear();
+}
+
 void FetchRequestData::appendResult(icalcomponent *comp)
 {
-    m_currentComponents = g_slist_append(m_currentComponents, comp);
+    m_currentComponents = g_slist_prepend(m_currentComponents, comp);
 }
 
 void FetchRequestData::appendDeatachedResult(icalcomponent *comp)
@@ -206,12 +323,7 @@ void FetchRequestData::appendDeatachedResult(icalcomponent *comp)
 
             // replace instance event
             icalcomponent_free (ical);
-            e->data = icalcomponent_new_clone(comp);
-            QString itemId = QString("%1/%2#%3")
-                    .arg(QString(m_current).replace(QOrganizerEDSEngineId::managerUriStatic() + ":", ""))
-                    .arg(QString::fromUtf8(uid))
-                    .arg(QString::fromUtf8(icaltime_as_ical_string(rid)));
-            m_deatachedIds.append(itemId);
+            e->data = isSummaryFetch() ? summaryComponent(comp) : icalcomponent_new_clone(comp);
             break;
         }
     }
@@ -227,12 +339,15 @@ int FetchRequestData::appendResults(QList<QOrganizerItem> results)
     QOrganizerItemFilter filter = req->filter();
     QList<QOrganizerItemSortOrder> sorting = req->sorting();
 
+    beginPhase(RequestStats::FilterSort);
     Q_FOREACH(QOrganizerItem item, results) {
         if (QOrganizerManagerEngine::testFilter(filter, item)) {
             QOrganizerManagerEngine::addSorted(&m_results, item, sorting);
             count++;
         }
     }
+    endPhase(RequestStats::FilterSort);
+    addItemCount(count);
     return count;
 }
 
@@ -266,6 +381,113 @@ QString FetchRequestData::dateFilter()
     return query;
 }
 
+bool FetchRequestData::isSummaryFetch() const
+{
+    return !m_summaryFields.isEmpty();
+}
+
+GSList *FetchRequestData::summaryFields() const
+{
+    GSList *fields = 0;
+    Q_FOREACH(const QByteArray &field, m_summaryFields) {
+        fields = g_slist_prepend(fields, g_strdup(field.constData()));
+    }
+    return g_slist_reverse(fields);
+}
+
+icalcomponent *FetchRequestData::summaryComponent(icalcomponent *comp) const
+{
+    icalcomponent *summary = icalcomponent_new(icalcomponent_isa(comp));
+    for (icalproperty *prop = icalcomponent_get_first_property(comp, ICAL_ANY_PROPERTY);
+         prop != NULL;
+         prop = icalcomponent_get_next_property(comp, ICAL_ANY_PROPERTY)) {
+        if (m_summaryProperties.contains(icalproperty_isa(prop))) {
+            icalcomponent_add_property(summary, icalproperty_new_clone(prop));
+        }
+    }
+    return summary;
+}
+
+void FetchRequestData::setView(ECalClientView *view)
+{
+    clearView();
+    m_view = view;
+}
+
+void FetchRequestData::clearView()
+{
+    if (m_view) {
+        g_signal_handlers_disconnect_by_data(m_view, this);
+        GError *gError = 0;
+        e_cal_client_view_stop(m_view, &gError);
+        if (gError) {
+            qWarning() << "Fail to stop view" << gError->message;
+            g_error_free(gError);
+        }
+        g_clear_object(&m_view);
+    }
+}
+
+QList<QByteArray> FetchRequestData::summaryFieldsFromHint(const QList<QOrganizerItemDetail::DetailType> &detailsHint)
+{
+    // empty hint means all details
+    if (detailsHint.isEmpty()) {
+        return QList<QByteArray>();
+    }
+
+    // necessary to identify the item and to resolve the recurrences
+    QList<QByteArray> fields;
+    fields << "UID" << "RECURRENCE-ID" << "DTSTART"
+           << "RRULE" << "RDATE" << "EXRULE" << "EXDATE"
+           << "SEQUENCE" << "LAST-MODIFIED";
+
+    Q_FOREACH(QOrganizerItemDetail::DetailType type, detailsHint) {
+        switch(type) {
+        case QOrganizerItemDetail::TypeDisplayLabel:
+            fields << "SUMMARY";
+            break;
+        case QOrganizerItemDetail::TypeDescription:
+            fields << "DESCRIPTION";
+            break;
+        case QOrganizerItemDetail::TypeComment:
+            fields << "COMMENT";
+            break;
+        case QOrganizerItemDetail::TypeTag:
+            fields << "CATEGORIES";
+            break;
+        case QOrganizerItemDetail::TypeLocation:
+            fields << "LOCATION";
+            break;
+        case QOrganizerItemDetail::TypePriority:
+            fields << "PRIORITY";
+            break;
+        case QOrganizerItemDetail::TypeEventTime:
+            fields << "DTEND" << "DURATION";
+            break;
+        case QOrganizerItemDetail::TypeTodoTime:
+            fields << "DUE";
+            break;
+        case QOrganizerItemDetail::TypeTodoProgress:
+            fields << "PERCENT-COMPLETE" << "STATUS";
+            break;
+        case QOrganizerItemDetail::TypeEventAttendee:
+            fields << "ATTENDEE";
+            break;
+        case QOrganizerItemDetail::TypeJournalTime:
+        case QOrganizerItemDetail::TypeRecurrence:
+        case QOrganizerItemDetail::TypeParent:
+        case QOrganizerItemDetail::TypeGuid:
+        case QOrganizerItemDetail::TypeItemType:
+            break;
+        default:
+            // reminders (VALARM) and extended details (X- properties) can not
+            // be selected by name, use the full component
+            return QList<QByteArray>();
+        }
+    }
+    return fields;
+}
+
 QStringList FetchRequestData::filterCollections(const QStringList &collections) const
 {
     QStringList result;
@@ -317,18 +539,13 @@ QStringList FetchRequestData::collectionsFromFilter(const QOrganizerItemFilter &
     return result;
 }
 
-FetchRequestDataParseListener::FetchRequestDataParseListener(FetchRequestData *data,
-                                                             QOrganizerManager::Error error,
-                                                             QOrganizerAbstractRequest::State state)
+FetchRequestDataParseListener::FetchRequestDataParseListener(FetchRequestData *data)
     : QObject(0),
-      m_data(data),
-      m_error(error),
-      m_state(state)
+      m_data(data)
 {
 }
 
 void FetchRequestDataParseListener::onParseDone(QList<QOrganizerItem> results)
 {
-    m_data->appendResults(results);
-    m_data->finishContinue(m_error, m_state);
+    m_data->onParseDone(results);
 }
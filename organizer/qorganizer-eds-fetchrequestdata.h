@@ -22,7 +22,15 @@
 #include "qorganizer-eds-requestdata.h"
 #include <glib.h>
 
+// set on a QOrganizerItemFetchRequest to fetch the stored items (series and
+// exceptions) matching the date interval instead of their occurrences
+#define FETCH_FOR_EXPORT_PROPERTY   "fetch-for-export"
+// set on a QOrganizerItemFetchRequest to expand the recurrences in process
+// instead of asking the backend for the occurrences
+#define LOCAL_EXPANSION_PROPERTY    "local-expansion"
+
 class FetchRequestDataParseListener;
+class SeriesExpansion;
 
 class FetchRequestData : public RequestData
 {
@@ -38,6 +46,7 @@ public:
     time_t startDate() const;
     time_t endDate() const;
     bool hasDateInterval() const;
+    bool isFetchForExport() const;
     bool filterIsValid() const;
     void cancel();
     void compileCurrentIds();
@@ -49,20 +58,51 @@ public:
     int appendResults(QList<QtOrganizer::QOrganizerItem> results);
     QString dateFilter();
 
+    // summary view: only the properties necessary for the fetch hint are requested
+    bool isSummaryFetch() const;
+    GSList *summaryFields() const;
+    icalcomponent *summaryComponent(icalcomponent *comp) const;
+    void setView(ECalClientView *view);
+    void clearView();
+
+    static QList<QByteArray> summaryFieldsFromHint(const QList<QtOrganizer::QOrganizerItemDetail::DetailType> &detailsHint);
+
+    // local expansion: recurrences are expanded in-process from the master components
+    bool isLocalExpansion() const;
+    void appendExpansion(SeriesExpansion *expansion);
+    // components listed for the interval, kept until the exceptions of their series are known
+    void setExpansionComponents(GSList *components);
+    GSList *expansionComponents() const;
+    void appendExpansionException(const QString &key);
+    const QSet<QString> &expansionExceptions() const;
+    void clearExpansionComponents();
+
 private:
     FetchRequestDataParseListener *m_parseListener;
-    QMap<QString, GSList*> m_components;
+    // each collection is parsed as soon as it is listed
+    int m_pendingParses;
+    bool m_finishing;
+    QtOrganizer::QOrganizerManager::Error m_finishError;
+    QtOrganizer::QOrganizerAbstractRequest::State m_finishState;
     QStringList m_collections;
     QSet<QString> m_currentParentIds;
-    QStringList m_deatachedIds;
     QString m_current;
     GSList* m_currentComponents;
+    QList<SeriesExpansion*> m_currentExpansions;
+    GSList *m_expansionComponents;
+    QSet<QString> m_expansionExceptions;
     QList<QtOrganizer::QOrganizerItem> m_results;
+    QList<QByteArray> m_summaryFields;
+    QSet<int> m_summaryProperties;
+    ECalClientView *m_view;
 
     QStringList filterCollections(const QStringList &collections) const;
     QStringList collectionsFromFilter(const QtOrganizer::QOrganizerItemFilter &f) const;
     void finishContinue(QtOrganizer::QOrganizerManager::Error error,
                         QtOrganizer::QOrganizerAbstractRequest::State state);
+    void parseCurrentCollection();
+    void clearCurrentCollection();
+    void onParseDone(const QList<QtOrganizer::QOrganizerItem> &results);
 
     friend class FetchRequestDataParseListener;
 };
@@ -71,17 +111,13 @@ class FetchRequestDataParseListener : public QObject
 {
     Q_OBJECT
 public:
-    FetchRequestDataParseListener(FetchRequestData *data,
-                                  QtOrganizer::QOrganizerManager::Error error,
-                                  QtOrganizer::QOrganizerAbstractRequest::State state);
+    FetchRequestDataParseListener(FetchRequestData *data);
 
 private Q_SLOTS:
     void onParseDone(QList<QtOrganizer::QOrganizerItem> results);
 
 private:
     FetchRequestData *m_data;
-    QtOrganizer::QOrganizerManager::Error m_error;
-    QtOrganizer::QOrganizerAbstractRequest::State m_state;
 };
 
 #endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-freebusy.h"
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QtAlgorithms>
+
+FreeBusy::FreeBusy(time_t start, time_t end)
+    : m_start(start),
+      m_end(end),
+      m_pending(0),
+      m_eventLoop(0)
+{
+}
+
+void FreeBusy::collect(ECalClient *client)
+{
+    m_pending++;
+    e_cal_client_generate_instances(client,
+                                    m_start,
+                                    m_end,
+                                    0,
+                                    (ECalRecurInstanceFn) FreeBusy::instanceListed,
+                                    this,
+                                    (GDestroyNotify) FreeBusy::collectDone);
+}
+
+void FreeBusy::wait()
+{
+    if (m_pending > 0) {
+        QEventLoop eventLoop;
+        m_eventLoop = &eventLoop;
+        eventLoop.exec();
+        m_eventLoop = 0;
+    }
+}
+
+void FreeBusy::collectDone(FreeBusy *self)
+{
+    self->m_pending--;
+    if ((self->m_pending == 0) && self->m_eventLoop) {
+        self->m_eventLoop->quit();
+    }
+}
+
+QList<FreeBusy::Interval> FreeBusy::busyIntervals() const
+{
+    return mergeIntervals(m_intervals);
+}
+
+QList<FreeBusy::Interval> FreeBusy::mergeIntervals(QList<Interval> intervals)
+{
+    QList<Interval> result;
+    if (intervals.isEmpty()) {
+        return result;
+    }
+
+    qSort(intervals);
+
+    Interval current = intervals.first();
+    for(int i = 1; i < intervals.size(); i++) {
+        const Interval &next = intervals[i];
+        if (next.first <= current.second) {
+            current.second = qMax(current.second, next.second);
+        } else {
+            result << current;
+            current = next;
+        }
+    }
+    result << current;
+    return result;
+}
+
+gboolean FreeBusy::instanceListed(ECalComponent *comp,
+                                  time_t instanceStart,
+                                  time_t instanceEnd,
+                                  FreeBusy *self)
+{
+    if (e_cal_component_get_vtype(comp) != E_CAL_COMPONENT_EVENT) {
+        return TRUE;
+    }
+
+    // cancelled events do not take any time
+    icalproperty_status status = ICAL_STATUS_NONE;
+    e_cal_component_get_status(comp, &status);
+    if (status == ICAL_STATUS_CANCELLED) {
+        return TRUE;
+    }
+
+    ECalComponentTransparency transparency = E_CAL_COMPONENT_TRANSP_NONE;
+    e_cal_component_get_transparency(comp, &transparency);
+    if (transparency == E_CAL_COMPONENT_TRANSP_TRANSPARENT) {
+        return TRUE;
+    }
+
+    // instances are reported if they overlap the range, keep only that part
+    time_t start = qMax(instanceStart, self->m_start);
+    time_t end = qMin(instanceEnd, self->m_end);
+    if (start < end) {
+        self->m_intervals << qMakePair(start, end);
+    }
+    return TRUE;
+}
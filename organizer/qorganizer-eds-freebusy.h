@@ -0,0 +1,62 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_FREEBUSY_H__
+#define __QORGANIZER_EDS_FREEBUSY_H__
+
+#include <QList>
+#include <QPair>
+
+#include <libecal/libecal.h>
+
+class QEventLoop;
+
+// Busy time of a calendar, computed from the event instances without
+// converting them to organizer items
+class FreeBusy
+{
+public:
+    typedef QPair<time_t, time_t> Interval;
+
+    FreeBusy(time_t start, time_t end);
+
+    // starts listing the instances of the client in background
+    void collect(ECalClient *client);
+    // blocks until every collect() is done
+    void wait();
+    QList<Interval> busyIntervals() const;
+
+    static QList<Interval> mergeIntervals(QList<Interval> intervals);
+
+private:
+    time_t m_start;
+    time_t m_end;
+    QList<Interval> m_intervals;
+    int m_pending;
+    QEventLoop *m_eventLoop;
+
+    static void collectDone(FreeBusy *self);
+    static gboolean instanceListed(ECalComponent *comp,
+                                   time_t instanceStart,
+                                   time_t instanceEnd,
+                                   FreeBusy *self);
+
+    Q_DISABLE_COPY(FreeBusy)
+};
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-metrics.h"
+#include "qorganizer-eds-recurrencecache.h"
+#include "qorganizer-eds-timezonecache.h"
+
+#include <QStringList>
+
+using namespace QtOrganizer;
+
+Q_GLOBAL_STATIC(EngineMetrics, engineMetrics)
+
+static const char *requestTypeName(int type)
+{
+    switch (type) {
+    case QOrganizerAbstractRequest::ItemOccurrenceFetchRequest:
+        return "occurrence-fetch";
+    case QOrganizerAbstractRequest::ItemFetchRequest:
+        return "fetch";
+    case QOrganizerAbstractRequest::ItemFetchForExportRequest:
+        return "fetch-for-export";
+    case QOrganizerAbstractRequest::ItemIdFetchRequest:
+        return "id-fetch";
+    case QOrganizerAbstractRequest::ItemFetchByIdRequest:
+        return "fetch-by-id";
+    case QOrganizerAbstractRequest::ItemRemoveRequest:
+        return "remove";
+    case QOrganizerAbstractRequest::ItemRemoveByIdRequest:
+        return "remove-by-id";
+    case QOrganizerAbstractRequest::ItemSaveRequest:
+        return "save";
+    case QOrganizerAbstractRequest::CollectionFetchRequest:
+        return "collection-fetch";
+    case QOrganizerAbstractRequest::CollectionRemoveRequest:
+        return "collection-remove";
+    case QOrganizerAbstractRequest::CollectionSaveRequest:
+        return "collection-save";
+    default:
+        return "invalid";
+    }
+}
+
+MetricsHistogram::MetricsHistogram()
+{
+}
+
+void MetricsHistogram::add(qint64 value)
+{
+    m_buckets[bucketIndex(value)].fetchAndAddRelaxed(1);
+}
+
+int MetricsHistogram::count() const
+{
+    int total = 0;
+    for(int i = 0; i < BucketCount; i++) {
+        total += m_buckets[i].load();
+    }
+    return total;
+}
+
+int MetricsHistogram::bucket(int index) const
+{
+    return m_buckets[index].load();
+}
+
+qint64 MetricsHistogram::percentile(int percent) const
+{
+    // the buckets may be updated while read, use a single snapshot
+    int counts[BucketCount];
+    int total = 0;
+    for(int i = 0; i < BucketCount; i++) {
+        counts[i] = m_buckets[i].load();
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    qint64 rank = (qint64(total) * percent + 99) / 100;
+    qint64 seen = 0;
+    for(int i = 0; i < BucketCount; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(BucketCount - 1);
+}
+
+QString MetricsHistogram::toString() const
+{
+    QStringList buckets;
+    for(int i = 0; i < BucketCount; i++) {
+        int value = m_buckets[i].load();
+        if (value) {
+            buckets << QString("%1:%2").arg(bucketUpperBound(i)).arg(value);
+        }
+    }
+    return QString("count=%1 p50=%2 p90=%3 p99=%4 buckets=%5")
+            .arg(count())
+            .arg(percentile(50))
+            .arg(percentile(90))
+            .arg(percentile(99))
+            .arg(buckets.join(","));
+}
+
+void MetricsHistogram::clear()
+{
+    for(int i = 0; i < BucketCount; i++) {
+        m_buckets[i].store(0);
+    }
+}
+
+int MetricsHistogram::bucketIndex(qint64 value)
+{
+    int index = 0;
+    while ((value > 0) && (index < (BucketCount - 1))) {
+        value >>= 1;
+        index++;
+    }
+    return index;
+}
+
+qint64 MetricsHistogram::bucketUpperBound(int index)
+{
+    return Q_INT64_C(1) << index;
+}
+
+EngineMetrics::EngineMetrics()
+{
+}
+
+EngineMetrics *EngineMetrics::instance()
+{
+    return engineMetrics();
+}
+
+void EngineMetrics::addRequestLatency(QOrganizerAbstractRequest::RequestType type, qint64 usecs)
+{
+    if ((int(type) > 0) && (int(type) < RequestTypeCount)) {
+        m_requestLatency[type].add(usecs);
+    }
+}
+
+void EngineMetrics::addParse(int items, qint64 usecs)
+{
+    if (items == 0) {
+        return;
+    }
+    m_parsedItems.fetchAndAddRelaxed(items);
+    m_parseThroughput.add((qint64(items) * 1000000) / qMax(usecs, Q_INT64_C(1)));
+}
+
+void EngineMetrics::addChangeSet(int size)
+{
+    m_changeSetSizes.add(size);
+}
+
+void EngineMetrics::viewWatcherCreated()
+{
+    m_viewWatchers.ref();
+}
+
+void EngineMetrics::viewWatcherDestroyed()
+{
+    m_viewWatchers.deref();
+}
+
+const MetricsHistogram &EngineMetrics::requestLatency(QOrganizerAbstractRequest::RequestType type) const
+{
+    if ((int(type) > 0) && (int(type) < RequestTypeCount)) {
+        return m_requestLatency[type];
+    }
+    return m_requestLatency[QOrganizerAbstractRequest::InvalidRequest];
+}
+
+const MetricsHistogram &EngineMetrics::parseThroughput() const
+{
+    return m_parseThroughput;
+}
+
+int EngineMetrics::parsedItems() const
+{
+    return m_parsedItems.load();
+}
+
+const MetricsHistogram &EngineMetrics::changeSetSizes() const
+{
+    return m_changeSetSizes;
+}
+
+int EngineMetrics::viewWatchers() const
+{
+    return m_viewWatchers.load();
+}
+
+QMap<QString, QString> EngineMetrics::toMap() const
+{
+    QMap<QString, QString> metrics;
+    for(int i = 1; i < RequestTypeCount; i++) {
+        if (m_requestLatency[i].count()) {
+            metrics.insert(QString("latency-%1").arg(requestTypeName(i)),
+                           m_requestLatency[i].toString());
+        }
+    }
+    metrics.insert("parse-throughput", m_parseThroughput.toString());
+    metrics.insert("parsed-items", QString::number(parsedItems()));
+    metrics.insert("change-set-size", m_changeSetSizes.toString());
+    metrics.insert("view-watchers", QString::number(viewWatchers()));
+
+    RecurrenceCache *recurrenceCache = RecurrenceCache::instance();
+    metrics.insert("recurrence-cache-hit-ratio",
+                   hitRatio(recurrenceCache->hits(), recurrenceCache->misses()));
+    TimeZoneCache *timeZoneCache = TimeZoneCache::instance();
+    metrics.insert("timezone-cache-hit-ratio",
+                   hitRatio(timeZoneCache->hits(), timeZoneCache->misses()));
+    return metrics;
+}
+
+void EngineMetrics::clear()
+{
+    for(int i = 0; i < RequestTypeCount; i++) {
+        m_requestLatency[i].clear();
+    }
+    m_parseThroughput.clear();
+    m_parsedItems.store(0);
+    m_changeSetSizes.clear();
+    // view watchers are a gauge, they are not reset
+}
+
+QString EngineMetrics::hitRatio(int hits, int misses)
+{
+    if ((hits + misses) == 0) {
+        return QStringLiteral("0");
+    }
+    return QString::number(double(hits) / (hits + misses), 'f', 3);
+}
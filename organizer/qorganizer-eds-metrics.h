@@ -0,0 +1,97 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_METRICS_H__
+#define __QORGANIZER_EDS_METRICS_H__
+
+#include <QMap>
+#include <QString>
+#include <QAtomicInt>
+
+#include <QtOrganizer/QOrganizerAbstractRequest>
+
+// Counts of values in power of two buckets, bucket 0 holds the values
+// lower than 1 and bucket n the values in [2^(n-1), 2^n)
+class MetricsHistogram
+{
+public:
+    enum { BucketCount = 32 };
+
+    MetricsHistogram();
+
+    void add(qint64 value);
+    int count() const;
+    int bucket(int index) const;
+    // upper bound of the bucket holding the percentile
+    qint64 percentile(int percent) const;
+    QString toString() const;
+    void clear();
+
+    static int bucketIndex(qint64 value);
+    static qint64 bucketUpperBound(int index);
+
+private:
+    QAtomicInt m_buckets[BucketCount];
+
+    Q_DISABLE_COPY(MetricsHistogram)
+};
+
+// Aggregated metrics of all the engines in the process, the counters are
+// lock-free so they can be updated from the parse threads
+class EngineMetrics
+{
+public:
+    static EngineMetrics *instance();
+
+    // InvalidRequest and unknown request types are not recorded
+    void addRequestLatency(QtOrganizer::QOrganizerAbstractRequest::RequestType type, qint64 usecs);
+    void addParse(int items, qint64 usecs);
+    void addChangeSet(int size);
+    void viewWatcherCreated();
+    void viewWatcherDestroyed();
+
+    // latency in microseconds, the empty InvalidRequest slot for unknown types
+    const MetricsHistogram &requestLatency(QtOrganizer::QOrganizerAbstractRequest::RequestType type) const;
+    // items parsed per second by each parse call
+    const MetricsHistogram &parseThroughput() const;
+    int parsedItems() const;
+    // number of items notified by each change set
+    const MetricsHistogram &changeSetSizes() const;
+    int viewWatchers() const;
+
+    // one entry per metric, the caches hit ratio is included
+    QMap<QString, QString> toMap() const;
+    void clear();
+
+    EngineMetrics();
+
+private:
+    static const int RequestTypeCount = QtOrganizer::QOrganizerAbstractRequest::CollectionSaveRequest + 1;
+
+    MetricsHistogram m_requestLatency[RequestTypeCount];
+    MetricsHistogram m_parseThroughput;
+    QAtomicInt m_parsedItems;
+    MetricsHistogram m_changeSetSizes;
+    QAtomicInt m_viewWatchers;
+
+    static QString hitRatio(int hits, int misses);
+
+    Q_DISABLE_COPY(EngineMetrics)
+};
+
+#endif
@@ -1,14 +1,28 @@
 #include "qorganizer-eds-parseeventthread.h"
 #include "qorganizer-eds-collection-engineid.h"
 #include "qorganizer-eds-engine.h"
+#include "qorganizer-eds-seriesexpansion.h"
 
 #include <QDebug>
+#include <QThreadPool>
+
+// parsing of concurrent fetches is queued instead of running all at once
+#define PARSE_MAX_THREADS 2
+
+class ParseThreadPool : public QThreadPool
+{
+public:
+    ParseThreadPool()
+    {
+        setMaxThreadCount(PARSE_MAX_THREADS);
+    }
+};
+
+Q_GLOBAL_STATIC(ParseThreadPool, parseThreadPool)
 
 QOrganizerParseEventThread::QOrganizerParseEventThread(QObject *source,
-                                                       const QByteArray &slot,
-                                                       QObject *parent)
-    : QThread(parent),
-      m_source(source)
+                                                       const QByteArray &slot)
+    : m_source(source)
 {
     qRegisterMetaType<QList<QOrganizerItem> >();
     int slotIndex = source->metaObject()->indexOfSlot(slot.mid(1));
@@ -17,8 +31,6 @@ QOrganizerParseEventThread::QOrganizerParseEventThread(QObject *source,
     } else {
         m_slot = source->metaObject()->method(slotIndex);
     }
-
-    connect(this, SIGNAL(finished()), SLOT(deleteLater()));
 }
 
 QOrganizerParseEventThread::~QOrganizerParseEventThread()
@@ -31,27 +43,42 @@ QOrganizerParseEventThread::~QOrganizerParseEventThread()
         }
     }
     m_events.clear();
+
+    Q_FOREACH(const QList<SeriesExpansion*> &expansions, m_expansions.values()) {
+        qDeleteAll(expansions);
+    }
+    m_expansions.clear();
 }
 
 void QOrganizerParseEventThread::start(QMap<QOrganizerEDSCollectionEngineId *, GSList *> events,
                                        bool isIcalEvents,
-                                       QList<QOrganizerItemDetail::DetailType> detailsHint)
+                                       QList<QOrganizerItemDetail::DetailType> detailsHint,
+                                       QMap<QOrganizerEDSCollectionEngineId *, QList<SeriesExpansion*> > expansions)
 {
     m_events = events;
+    m_expansions = expansions;
     m_isIcalEvents = isIcalEvents;
     m_detailsHint = detailsHint;
-    QThread::start();
+    parseThreadPool()->start(this);
 }
 
 void QOrganizerParseEventThread::run()
 {
     QList<QOrganizerItem> result;
+    QOrganizerEDSEngine::DetailsMask detailsMask = QOrganizerEDSEngine::detailsMask(m_detailsHint);
 
     Q_FOREACH(QOrganizerEDSCollectionEngineId *id, m_events.keys()) {
         if (!m_source) {
             break;
         }
-        result += QOrganizerEDSEngine::parseEvents(id, m_events.value(id), m_isIcalEvents, m_detailsHint);
+        result += QOrganizerEDSEngine::parseEvents(id, m_events.value(id), m_isIcalEvents, detailsMask);
+    }
+
+    Q_FOREACH(QOrganizerEDSCollectionEngineId *id, m_expansions.keys()) {
+        if (!m_source) {
+            break;
+        }
+        result += QOrganizerEDSEngine::parseExpansions(id, m_expansions.value(id), detailsMask);
     }
 
     if (m_source && m_slot.isValid()) {
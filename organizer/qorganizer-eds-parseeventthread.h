@@ -22,7 +22,7 @@
 #include <QObject>
 #include <QList>
 #include <QPointer>
-#include <QThread>
+#include <QRunnable>
 #include <QByteArray>
 #include <QMetaMethod>
 
@@ -32,27 +32,28 @@
 #include <glib.h>
 
 class QOrganizerEDSCollectionEngineId;
+class SeriesExpansion;
 
-class QOrganizerParseEventThread : public QThread
+// runs on a shared pool with a bounded number of threads, deleted when done
+class QOrganizerParseEventThread : public QRunnable
 {
-    Q_OBJECT
 public:
     QOrganizerParseEventThread(QObject *source,
-                               const QByteArray &slot,
-                               QObject *parent = 0);
+                               const QByteArray &slot);
     ~QOrganizerParseEventThread();
 
     void start(QMap<QOrganizerEDSCollectionEngineId *, GSList *> events,
                bool isIcalEvents,
-               QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint);
+               QList<QtOrganizer::QOrganizerItemDetail::DetailType> detailsHint,
+               QMap<QOrganizerEDSCollectionEngineId *, QList<SeriesExpansion*> > expansions = QMap<QOrganizerEDSCollectionEngineId *, QList<SeriesExpansion*> >());
 
 private:
     QPointer<QObject> m_source;
     QMetaMethod m_slot;
-    bool m_abort;
 
     // parse data
     QMap<QOrganizerEDSCollectionEngineId *, GSList *> m_events;
+    QMap<QOrganizerEDSCollectionEngineId *, QList<SeriesExpansion*> > m_expansions;
     bool m_isIcalEvents;
     QList<QtOrganizer::QOrganizerItemDetail::DetailType> m_detailsHint;
 
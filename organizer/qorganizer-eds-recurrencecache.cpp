@@ -0,0 +1,134 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-recurrencecache.h"
+
+#include <QMutexLocker>
+
+// number of series kept in memory
+#define RECURRENCE_CACHE_SIZE 512
+// versions kept for each series (master and exceptions)
+#define RECURRENCE_CACHE_SERIES_SIZE 4
+
+using namespace QtOrganizer;
+
+Q_GLOBAL_STATIC(RecurrenceCache, recurrenceCache)
+
+RecurrenceCache::RecurrenceCache()
+    : m_entries(RECURRENCE_CACHE_SIZE)
+{
+}
+
+RecurrenceCache *RecurrenceCache::instance()
+{
+    return recurrenceCache();
+}
+
+int RecurrenceCache::recurrencePropertiesCount(icalcomponent *ical)
+{
+    return icalcomponent_count_properties(ical, ICAL_RRULE_PROPERTY) +
+           icalcomponent_count_properties(ical, ICAL_RDATE_PROPERTY) +
+           icalcomponent_count_properties(ical, ICAL_EXDATE_PROPERTY);
+}
+
+RecurrenceCache::Entry RecurrenceCache::entryFor(icalcomponent *ical)
+{
+    Entry entry;
+    entry.sequence = icalcomponent_get_sequence(ical);
+    entry.lastModified = 0;
+    icalproperty *prop = icalcomponent_get_first_property(ical, ICAL_LASTMODIFIED_PROPERTY);
+    if (prop) {
+        entry.lastModified = icaltime_as_timet(icalproperty_get_lastmodified(prop));
+    }
+    entry.properties = recurrencePropertiesCount(ical);
+    return entry;
+}
+
+bool RecurrenceCache::find(const QString &collectionId, icalcomponent *ical, QOrganizerItemRecurrence *recurrence)
+{
+    const char *uid = icalcomponent_get_uid(ical);
+    if (!uid) {
+        return false;
+    }
+
+    Entry key = entryFor(ical);
+    QMutexLocker locker(&m_lock);
+    QList<Entry> *entries = m_entries.object(Key(collectionId, QString::fromUtf8(uid)));
+    if (entries) {
+        Q_FOREACH(const Entry &entry, *entries) {
+            if ((entry.sequence == key.sequence) &&
+                (entry.lastModified == key.lastModified) &&
+                (entry.properties == key.properties)) {
+                m_hits.ref();
+                *recurrence = entry.recurrence;
+                return true;
+            }
+        }
+    }
+    m_misses.ref();
+    return false;
+}
+
+void RecurrenceCache::insert(const QString &collectionId, icalcomponent *ical, const QOrganizerItemRecurrence &recurrence)
+{
+    const char *uid = icalcomponent_get_uid(ical);
+    if (!uid) {
+        return;
+    }
+
+    Entry entry = entryFor(ical);
+    entry.recurrence = recurrence;
+
+    Key key(collectionId, QString::fromUtf8(uid));
+    QMutexLocker locker(&m_lock);
+    QList<Entry> *entries = m_entries.object(key);
+    if (entries) {
+        if (entries->size() >= RECURRENCE_CACHE_SERIES_SIZE) {
+            entries->removeFirst();
+        }
+        entries->append(entry);
+    } else {
+        entries = new QList<Entry>;
+        entries->append(entry);
+        m_entries.insert(key, entries);
+    }
+}
+
+void RecurrenceCache::remove(const QString &collectionId, const QString &uid)
+{
+    QMutexLocker locker(&m_lock);
+    m_entries.remove(Key(collectionId, uid));
+}
+
+int RecurrenceCache::hits() const
+{
+    return m_hits.load();
+}
+
+int RecurrenceCache::misses() const
+{
+    return m_misses.load();
+}
+
+void RecurrenceCache::clear()
+{
+    QMutexLocker locker(&m_lock);
+    m_entries.clear();
+    m_hits.store(0);
+    m_misses.store(0);
+}
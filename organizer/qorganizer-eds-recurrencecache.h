@@ -0,0 +1,75 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_RECURRENCECACHE_H__
+#define __QORGANIZER_EDS_RECURRENCECACHE_H__
+
+#include <QCache>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include <QtOrganizer/QOrganizerItemRecurrence>
+
+#include <libecal/libecal.h>
+
+// Converted recurrence details shared by all occurrences of a series,
+// the same uid may exist in several collections; all functions are
+// thread-safe
+class RecurrenceCache
+{
+public:
+    static RecurrenceCache *instance();
+
+    bool find(const QString &collectionId, icalcomponent *ical, QtOrganizer::QOrganizerItemRecurrence *recurrence);
+    void insert(const QString &collectionId, icalcomponent *ical, const QtOrganizer::QOrganizerItemRecurrence &recurrence);
+    void remove(const QString &collectionId, const QString &uid);
+
+    int hits() const;
+    int misses() const;
+    void clear();
+
+    static int recurrencePropertiesCount(icalcomponent *ical);
+
+    RecurrenceCache();
+
+private:
+    struct Entry
+    {
+        int sequence;
+        qint64 lastModified;
+        // exceptions share uid and sequence with the master but not its rules
+        int properties;
+        QtOrganizer::QOrganizerItemRecurrence recurrence;
+    };
+
+    typedef QPair<QString, QString> Key;
+
+    QMutex m_lock;
+    // (collection id, series uid) -> known versions of the series
+    QCache<Key, QList<Entry> > m_entries;
+    QAtomicInt m_hits;
+    QAtomicInt m_misses;
+
+    static Entry entryFor(icalcomponent *ical);
+
+    Q_DISABLE_COPY(RecurrenceCache)
+};
+
+#endif
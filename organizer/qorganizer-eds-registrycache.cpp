@@ -0,0 +1,142 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-registrycache.h"
+#include "qorganizer-eds-collection-engineid.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+
+using namespace QtOrganizer;
+
+static const quint32 REGISTRY_CACHE_MAGIC = 0x51454443; // "QEDC"
+static const quint32 REGISTRY_CACHE_VERSION = 2;
+
+RegistryCache::RegistryCache(const QString &fileName)
+    : m_fileName(fileName),
+      m_isValid(false)
+{
+}
+
+bool RegistryCache::load()
+{
+    m_isValid = false;
+    m_collections.clear();
+    m_defaultCollection = QOrganizerCollection();
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly) || (file.size() == 0)) {
+        return false;
+    }
+
+    // the file is mapped, the stream reads it without copying it first
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        qWarning() << "Fail to map registry cache" << m_fileName << file.errorString();
+        return false;
+    }
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data), file.size());
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if ((magic != REGISTRY_CACHE_MAGIC) || (version != REGISTRY_CACHE_VERSION)) {
+        qWarning() << "Ignoring registry cache with unknown format" << m_fileName;
+        file.unmap(data);
+        return false;
+    }
+
+    QString defaultCollectionId;
+    quint32 count = 0;
+    in >> defaultCollectionId >> count;
+    for(quint32 i = 0; (i < count) && (in.status() == QDataStream::Ok); i++) {
+        QString collectionId;
+        QMap<int, QVariant> metaData;
+        in >> collectionId >> metaData;
+
+        QOrganizerCollection collection;
+        collection.setId(QOrganizerCollectionId(new QOrganizerEDSCollectionEngineId(collectionId)));
+        QMap<int, QVariant>::const_iterator it = metaData.constBegin();
+        for(; it != metaData.constEnd(); it++) {
+            collection.setMetaData(static_cast<QOrganizerCollection::MetaDataKey>(it.key()), it.value());
+        }
+
+        m_collections << collection;
+        if (collectionId == defaultCollectionId) {
+            m_defaultCollection = collection;
+        }
+    }
+
+    m_isValid = (in.status() == QDataStream::Ok);
+    if (!m_isValid) {
+        qWarning() << "Fail to read registry cache" << m_fileName;
+        m_collections.clear();
+        m_defaultCollection = QOrganizerCollection();
+    }
+    file.unmap(data);
+    return m_isValid;
+}
+
+bool RegistryCache::save(const QList<QOrganizerCollection> &collections,
+                         const QOrganizerCollectionId &defaultCollectionId) const
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Fail to write registry cache" << m_fileName << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << REGISTRY_CACHE_MAGIC << REGISTRY_CACHE_VERSION;
+    out << defaultCollectionId.toString() << quint32(collections.count());
+    Q_FOREACH(const QOrganizerCollection &collection, collections) {
+        QMap<int, QVariant> metaData;
+        QMap<QOrganizerCollection::MetaDataKey, QVariant> collectionMetaData = collection.metaData();
+        QMap<QOrganizerCollection::MetaDataKey, QVariant>::const_iterator it = collectionMetaData.constBegin();
+        for(; it != collectionMetaData.constEnd(); it++) {
+            metaData.insert(it.key(), it.value());
+        }
+        out << collection.id().toString() << metaData;
+    }
+
+    return file.commit();
+}
+
+bool RegistryCache::isValid() const
+{
+    return m_isValid;
+}
+
+QList<QOrganizerCollection> RegistryCache::collections() const
+{
+    return m_collections;
+}
+
+QOrganizerCollection RegistryCache::defaultCollection() const
+{
+    return m_defaultCollection;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_REGISTRYCACHE_H__
+#define __QORGANIZER_EDS_REGISTRYCACHE_H__
+
+#include <QtCore/QString>
+#include <QtCore/QList>
+
+#include <QtOrganizer/QOrganizerCollection>
+
+// On-disk copy of the collection list, used to answer the first requests
+// of a new process while the source registry is still loading; it is not
+// reconciled with the backends, the live list replaces it once loaded
+class RegistryCache
+{
+public:
+    RegistryCache(const QString &fileName);
+
+    bool load();
+    bool save(const QList<QtOrganizer::QOrganizerCollection> &collections,
+              const QtOrganizer::QOrganizerCollectionId &defaultCollectionId) const;
+
+    bool isValid() const;
+    QList<QtOrganizer::QOrganizerCollection> collections() const;
+    QtOrganizer::QOrganizerCollection defaultCollection() const;
+
+private:
+    QString m_fileName;
+    bool m_isValid;
+    QList<QtOrganizer::QOrganizerCollection> m_collections;
+    QtOrganizer::QOrganizerCollection m_defaultCollection;
+
+    Q_DISABLE_COPY(RegistryCache)
+};
+
+#endif
@@ -31,10 +31,8 @@ RemoveByIdRequestData::RemoveByIdRequestData(QOrganizerEDSEngine *engine, QtOrga
       m_currentCompIds(0)
 {
     Q_FOREACH(const QOrganizerItemId &id, request<QOrganizerItemRemoveByIdRequest>()->itemIds()) {
-        QString strId = id.toString();
         QString collectionId;
-        if (strId.contains("/")) {
-            collectionId = strId.split("/").first();
+        if (QOrganizerEDSEngineId::splitItemId(id.toString(), &collectionId)) {
             QSet<QOrganizerItemId> ids = m_pending.value(collectionId);
             ids << id;
             m_pending.insert(collectionId, ids);
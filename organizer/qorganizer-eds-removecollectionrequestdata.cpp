@@ -29,19 +29,28 @@ using namespace QtOrganizer;
 
 RemoveCollectionRequestData::RemoveCollectionRequestData(QOrganizerEDSEngine *engine, QtOrganizer::QOrganizerAbstractRequest *req)
     : RequestData(engine, req),
-      m_currentCollection(0),
-      m_remoteDeletable(false)
+      m_running(0)
 {
     m_pendingCollections = request<QOrganizerCollectionRemoveRequest>()->collectionIds();
 }
 
 RemoveCollectionRequestData::~RemoveCollectionRequestData()
 {
+    Q_FOREACH(RemoveCollectionOperation *op, m_operations) {
+        stopWaiting(op);
+        g_object_unref(op->source);
+        delete op;
+    }
+    m_operations.clear();
 }
 
 void RemoveCollectionRequestData::finish(QOrganizerManager::Error error,
                                          QOrganizerAbstractRequest::State state)
 {
+    // the request error is the last one reported by a collection
+    if ((error == QOrganizerManager::NoError) && !m_errorMap.isEmpty()) {
+        error = m_errorMap.last();
+    }
     QOrganizerManagerEngine::updateCollectionRemoveRequest(request<QOrganizerCollectionRemoveRequest>(),
                                                            error,
                                                            m_errorMap,
@@ -51,35 +60,60 @@ void RemoveCollectionRequestData::finish(QOrganizerManager::Error error,
     RequestData::finish(error, state);
 }
 
-void RemoveCollectionRequestData::commit(QtOrganizer::QOrganizerManager::Error error)
+QList<RemoveCollectionOperation*> RemoveCollectionRequestData::begin()
 {
-    if (error != QOrganizerManager::NoError) {
-        m_errorMap.insert(m_currentCollection, error);
-    } else {
-        QOrganizerCollectionId cId = m_pendingCollections.at(m_currentCollection);
-        parent()->d->m_sourceRegistry->remove(cId.toString());
-    }
+    for(int i = 0; i < m_pendingCollections.size(); i++) {
+        ESource *source = parent()->d->m_sourceRegistry->source(m_pendingCollections[i].toString());
+        if (!source) {
+            m_errorMap.insert(i, QOrganizerManager::InvalidCollectionError);
+            continue;
+        }
 
-    m_currentCollection++;
-    m_remoteDeletable = false;
+        RemoveCollectionOperation *op = new RemoveCollectionOperation;
+        op->data = this;
+        op->index = i;
+        op->source = E_SOURCE(g_object_ref(source));
+        op->remoteDeletable = false;
+        op->waiting = false;
+        op->removableChangedId = 0;
+        op->deletableChangedId = 0;
+        op->timeoutId = 0;
+        m_operations << op;
+    }
+    m_running = m_operations.size();
+    return m_operations;
 }
 
-bool RemoveCollectionRequestData::remoteDeletable() const
+void RemoveCollectionRequestData::commit(RemoveCollectionOperation *op,
+                                         QtOrganizer::QOrganizerManager::Error error)
 {
-    return m_remoteDeletable;
+    if (error != QOrganizerManager::NoError) {
+        m_errorMap.insert(op->index, error);
+    } else {
+        QOrganizerCollectionId cId = m_pendingCollections.at(op->index);
+        parent()->d->m_sourceRegistry->remove(cId.toString());
+    }
 }
 
-void RemoveCollectionRequestData::setRemoteDeletable(bool deletable)
+bool RemoveCollectionRequestData::end(RemoveCollectionOperation *op)
 {
-    m_remoteDeletable = deletable;
+    stopWaiting(op);
+    m_running--;
+    return (m_running <= 0);
 }
 
-ESource *RemoveCollectionRequestData::begin()
+void RemoveCollectionRequestData::stopWaiting(RemoveCollectionOperation *op)
 {
-    if (m_pendingCollections.count() > m_currentCollection) {
-        QOrganizerCollectionId cId = m_pendingCollections.at(m_currentCollection);
-        return parent()->d->m_sourceRegistry->source(cId.toString());
-    } else {
-        return 0;
+    if (op->removableChangedId) {
+        g_signal_handler_disconnect(op->source, op->removableChangedId);
+        op->removableChangedId = 0;
+    }
+    if (op->deletableChangedId) {
+        g_signal_handler_disconnect(op->source, op->deletableChangedId);
+        op->deletableChangedId = 0;
+    }
+    if (op->timeoutId) {
+        g_source_remove(op->timeoutId);
+        op->timeoutId = 0;
     }
 }
@@ -23,6 +23,23 @@
 
 #include <glib.h>
 
+// time (msecs) to wait for EDS to make a source removable
+#define REMOVE_COLLECTION_REMOVABLE_TIMEOUT 5000
+
+class RemoveCollectionRequestData;
+
+struct RemoveCollectionOperation
+{
+    RemoveCollectionRequestData *data;
+    int index;
+    ESource *source;
+    bool remoteDeletable;
+    bool waiting;
+    gulong removableChangedId;
+    gulong deletableChangedId;
+    guint timeoutId;
+};
+
 class RemoveCollectionRequestData : public RequestData
 {
 public:
@@ -32,17 +49,19 @@ public:
     void finish(QtOrganizer::QOrganizerManager::Error error = QtOrganizer::QOrganizerManager::NoError,
                 QtOrganizer::QOrganizerAbstractRequest::State state = QtOrganizer::QOrganizerAbstractRequest::FinishedState);
 
-    ESource* begin();
-    void commit(QtOrganizer::QOrganizerManager::Error error = QtOrganizer::QOrganizerManager::NoError);
+    // one operation per existing collection, all of them run at the same time
+    QList<RemoveCollectionOperation*> begin();
+    void commit(RemoveCollectionOperation *op,
+                QtOrganizer::QOrganizerManager::Error error = QtOrganizer::QOrganizerManager::NoError);
+    bool end(RemoveCollectionOperation *op);
 
-    bool remoteDeletable() const;
-    void setRemoteDeletable(bool deletable);
+    static void stopWaiting(RemoveCollectionOperation *op);
 
 private:
     QList<QtOrganizer::QOrganizerCollectionId> m_pendingCollections;
     QMap<int, QtOrganizer::QOrganizerManager::Error> m_errorMap;
-    int m_currentCollection;
-    bool m_remoteDeletable;
+    QList<RemoveCollectionOperation*> m_operations;
+    int m_running;
 };
 
 #endif
@@ -17,6 +17,7 @@
  */
 
 #include "qorganizer-eds-requestdata.h"
+#include "qorganizer-eds-metrics.h"
 
 #include <QtCore/QDebug>
 #include <QtCore/QEventLoop>
@@ -34,6 +35,13 @@ RequestData::RequestData(QOrganizerEDSEngine *engine, QtOrganizer::QOrganizerAbs
       m_finished(false),
       m_req(req)
 {
+    m_elapsed.start();
+    for(int i = 0; i < RequestStats::PhaseCount; i++) {
+        m_phaseStart[i] = -1;
+    }
+    m_phaseStart[RequestStats::Queued] = 0;
+    m_stats.type = req->type();
+
     QOrganizerManagerEngine::updateRequestState(req, QOrganizerAbstractRequest::ActiveState);
     m_cancellable = g_cancellable_new();
     m_parent->m_runningRequests.insert(req, this);
@@ -135,8 +143,9 @@ void RequestData::deleteLater()
 void RequestData::finish(QOrganizerManager::Error error,
                          QOrganizerAbstractRequest::State state)
 {
-    Q_UNUSED(error);
-    Q_UNUSED(state);
+    if (!m_finished) {
+        recordStats(error, state);
+    }
     m_finished = true;
 
     // When cancelling an operation the callback passed for the async function
@@ -146,6 +155,47 @@ void RequestData::finish(QOrganizerManager::Error error,
     }
 }
 
+void RequestData::beginPhase(RequestStats::Phase phase)
+{
+    endPhase(RequestStats::Queued);
+    if (m_phaseStart[phase] < 0) {
+        m_phaseStart[phase] = elapsedUsecs();
+    }
+}
+
+void RequestData::endPhase(RequestStats::Phase phase)
+{
+    if (m_phaseStart[phase] >= 0) {
+        m_stats.phases[phase] += elapsedUsecs() - m_phaseStart[phase];
+        m_phaseStart[phase] = -1;
+    }
+}
+
+void RequestData::addItemCount(int count)
+{
+    m_stats.items += count;
+}
+
+qint64 RequestData::elapsedUsecs() const
+{
+    return m_elapsed.nsecsElapsed() / 1000;
+}
+
+void RequestData::recordStats(QOrganizerManager::Error error,
+                              QOrganizerAbstractRequest::State state)
+{
+    for(int i = 0; i < RequestStats::PhaseCount; i++) {
+        endPhase(static_cast<RequestStats::Phase>(i));
+    }
+    m_stats.total = elapsedUsecs();
+    m_stats.error = error;
+    m_stats.state = state;
+    EngineMetrics::instance()->addRequestLatency(m_stats.type, m_stats.total);
+    if (!m_parent.isNull()) {
+        m_parent->d->m_requestStats->append(m_stats);
+    }
+}
+
 void RequestData::setClient(EClient *client)
 {
     if (m_client == client) {
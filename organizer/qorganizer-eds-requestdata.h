@@ -21,10 +21,12 @@
 
 #include "qorganizer-eds-engine.h"
 #include "qorganizer-eds-enginedata.h"
+#include "qorganizer-eds-requeststats.h"
 
 #include <QtCore/QPointer>
 #include <QtCore/QMutex>
 #include <QtCore/QEventLoop>
+#include <QtCore/QElapsedTimer>
 
 #include <QtOrganizer/QOrganizerAbstractRequest>
 #include <QtOrganizer/QOrganizerManager>
@@ -45,6 +47,11 @@ public:
     void wait(int msec = 0);
     bool isWaiting();
 
+    // stats, the queued phase ends with the first phase started
+    void beginPhase(RequestStats::Phase phase);
+    void endPhase(RequestStats::Phase phase);
+    void addItemCount(int count);
+
     template<class T>
     T* request() const {
         if (m_req) {
@@ -77,7 +84,15 @@ private:
     QPointer<QtOrganizer::QOrganizerAbstractRequest> m_req;
     GCancellable *m_cancellable;
 
+    QElapsedTimer m_elapsed;
+    qint64 m_phaseStart[RequestStats::PhaseCount];
+    RequestStats m_stats;
+
     static int m_instanceCount;
+
+    qint64 elapsedUsecs() const;
+    void recordStats(QtOrganizer::QOrganizerManager::Error error,
+                     QtOrganizer::QOrganizerAbstractRequest::State state);
 };
 
 #endif
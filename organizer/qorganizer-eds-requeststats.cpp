@@ -0,0 +1,98 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-requeststats.h"
+
+#include <QtCore/QDebug>
+
+using namespace QtOrganizer;
+
+RequestStats::RequestStats()
+    : type(QOrganizerAbstractRequest::InvalidRequest),
+      state(QOrganizerAbstractRequest::InactiveState),
+      error(QOrganizerManager::NoError),
+      total(0),
+      items(0)
+{
+    for(int i = 0; i < PhaseCount; i++) {
+        phases[i] = 0;
+    }
+}
+
+QString RequestStats::toString() const
+{
+    QString line = QString("type=%1 state=%2 error=%3 total=%4")
+            .arg(type).arg(state).arg(error).arg(total);
+    for(int i = 0; i < PhaseCount; i++) {
+        line += QString(" %1=%2").arg(phaseName(static_cast<Phase>(i))).arg(phases[i]);
+    }
+    line += QString(" items=%1").arg(items);
+    return line;
+}
+
+const char *RequestStats::phaseName(Phase phase)
+{
+    switch (phase) {
+    case Queued:
+        return "queued";
+    case ClientConnect:
+        return "connect";
+    case DBusCall:
+        return "dbus";
+    case DetachedInstances:
+        return "detached";
+    case Parse:
+        return "parse";
+    case FilterSort:
+        return "filter";
+    case Delivery:
+        return "delivery";
+    default:
+        return "unknown";
+    }
+}
+
+RequestStatsLog::RequestStatsLog(int capacity)
+    : m_stats(capacity),
+      m_next(0),
+      m_count(0),
+      m_logEnabled(!qgetenv("QORGANIZER_EDS_STATS").isEmpty())
+{
+}
+
+void RequestStatsLog::append(const RequestStats &stats)
+{
+    m_stats[m_next] = stats;
+    m_next = (m_next + 1) % m_stats.size();
+    m_count = qMin(m_count + 1, m_stats.size());
+
+    if (m_logEnabled) {
+        qDebug("qorganizer-eds request %s", qPrintable(stats.toString()));
+    }
+}
+
+QList<RequestStats> RequestStatsLog::stats() const
+{
+    // oldest first
+    QList<RequestStats> result;
+    int first = (m_next - m_count + m_stats.size()) % m_stats.size();
+    for(int i = 0; i < m_count; i++) {
+        result << m_stats.at((first + i) % m_stats.size());
+    }
+    return result;
+}
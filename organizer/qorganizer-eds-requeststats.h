@@ -0,0 +1,76 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_REQUESTSTATS_H__
+#define __QORGANIZER_EDS_REQUESTSTATS_H__
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include <QtOrganizer/QOrganizerAbstractRequest>
+#include <QtOrganizer/QOrganizerManager>
+
+// Time spent by a finished request in each phase, in microseconds.
+// Phases may overlap, e.g. parsing one collection while listing the next
+struct RequestStats
+{
+    enum Phase {
+        Queued = 0,
+        ClientConnect,
+        DBusCall,
+        DetachedInstances,
+        Parse,
+        FilterSort,
+        Delivery,
+        PhaseCount
+    };
+
+    RequestStats();
+
+    QtOrganizer::QOrganizerAbstractRequest::RequestType type;
+    QtOrganizer::QOrganizerAbstractRequest::State state;
+    QtOrganizer::QOrganizerManager::Error error;
+    qint64 phases[PhaseCount];
+    qint64 total;
+    int items;
+
+    QString toString() const;
+    static const char *phaseName(Phase phase);
+};
+
+// Stats of the last finished requests, optionally logged one line per
+// request when QORGANIZER_EDS_STATS is set
+class RequestStatsLog
+{
+public:
+    RequestStatsLog(int capacity = 128);
+
+    void append(const RequestStats &stats);
+    QList<RequestStats> stats() const;
+
+private:
+    QVector<RequestStats> m_stats;
+    int m_next;
+    int m_count;
+    bool m_logEnabled;
+
+    Q_DISABLE_COPY(RequestStatsLog)
+};
+
+#endif
@@ -34,7 +34,8 @@ SaveCollectionRequestData::SaveCollectionRequestData(QOrganizerEDSEngine *engine
                                                      QtOrganizer::QOrganizerAbstractRequest *req)
     : RequestData(engine, req),
       m_currentSources(0),
-      m_registry(0)
+      m_registry(0),
+      m_pendingUpdates(0)
 {
     parseCollections();
 }
@@ -89,7 +90,12 @@ void SaveCollectionRequestData::commitSourceCreated()
 void SaveCollectionRequestData::commitSourceUpdated(ESource *source,
                                                     QOrganizerManager::Error error)
 {
-    int index = m_sourcesToUpdate.firstKey();
+    // writes complete in any order, match the result by source
+    int index = m_sourcesToUpdate.key(source, -1);
+    if (index < 0) {
+        qWarning() << "Unknown source updated" << e_source_get_uid(source);
+        return;
+    }
     m_sourcesToUpdate.remove(index);
 
     if (error == QOrganizerManager::NoError) {
@@ -110,13 +116,16 @@ void SaveCollectionRequestData::commitSourceUpdated(ESource *source,
     }
 }
 
-ESource *SaveCollectionRequestData::nextSourceToUpdate()
+QList<ESource*> SaveCollectionRequestData::beginUpdate()
 {
-    if (m_sourcesToUpdate.size() > 0) {
-        return m_sourcesToUpdate.first();
-    } else {
-        return 0;
-    }
+    m_pendingUpdates = m_sourcesToUpdate.size();
+    return m_sourcesToUpdate.values();
+}
+
+bool SaveCollectionRequestData::endUpdate()
+{
+    m_pendingUpdates--;
+    return (m_pendingUpdates <= 0);
 }
 
 bool SaveCollectionRequestData::prepareToCreate()
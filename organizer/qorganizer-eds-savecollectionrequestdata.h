@@ -39,11 +39,14 @@ public:
     GList *sourcesToCreate() const;
     void commitSourceCreated();
     void commitSourceUpdated(ESource *source, QtOrganizer::QOrganizerManager::Error error = QtOrganizer::QOrganizerManager::NoError);
-    ESource *nextSourceToUpdate();
+    // all sources are written at once, endUpdate returns true when the last write completes
+    QList<ESource*> beginUpdate();
+    bool endUpdate();
 
 private:
     GList *m_currentSources;
     ESourceRegistry *m_registry;
+    int m_pendingUpdates;
 
     QMap<int, QtOrganizer::QOrganizerManager::Error> m_errorMap;
     QMap<int, QtOrganizer::QOrganizerCollection> m_results;
@@ -49,12 +49,16 @@ SaveRequestData::~SaveRequestData()
 void SaveRequestData::finish(QtOrganizer::QOrganizerManager::Error error,
                              QtOrganizer::QOrganizerAbstractRequest::State state)
 {
+    beginPhase(RequestStats::DBusCall);
     e_client_refresh_sync(m_client, 0, 0);
+    endPhase(RequestStats::DBusCall);
+    beginPhase(RequestStats::Delivery);
     QOrganizerManagerEngine::updateItemSaveRequest(request<QOrganizerItemSaveRequest>(),
                                                    m_result,
                                                    error,
                                                    m_erros,
                                                    state);
+    endPhase(RequestStats::Delivery);
     // Change will be fired by the viewwatcher
     RequestData::finish(error, state);
 }
@@ -62,6 +66,7 @@ void SaveRequestData::finish(QtOrganizer::QOrganizerManager::Error error,
 void SaveRequestData::appendResults(QList<QOrganizerItem> result)
 {
     m_result += result;
+    addItemCount(result.size());
 }
 
 QString SaveRequestData::nextCollection()
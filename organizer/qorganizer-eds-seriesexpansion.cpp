@@ -0,0 +1,155 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-seriesexpansion.h"
+
+SeriesExpansion::SeriesExpansion(ECalComponent *master)
+    : m_master(E_CAL_COMPONENT(g_object_ref(master))),
+      m_zone(0),
+      m_isDate(false),
+      m_exceptions(0)
+{
+}
+
+SeriesExpansion::~SeriesExpansion()
+{
+    g_object_unref(m_master);
+}
+
+ECalComponent *SeriesExpansion::master() const
+{
+    return m_master;
+}
+
+QByteArray SeriesExpansion::tzId() const
+{
+    return m_tzId;
+}
+
+const QVector<SeriesExpansion::Occurrence> &SeriesExpansion::occurrences() const
+{
+    return m_occurrences;
+}
+
+icaltimezone *SeriesExpansion::startZone(ECalClient *client,
+                                         ECalComponent *comp,
+                                         QByteArray *tzId,
+                                         bool *isDate)
+{
+    // same rules used by libecal to convert floating and date values
+    icaltimezone *zone = e_cal_client_get_default_timezone(client);
+    ECalComponentDateTime dt;
+    e_cal_component_get_dtstart(comp, &dt);
+    if (dt.value) {
+        *isDate = icaltime_is_date(*dt.value);
+        if (icaltime_is_utc(*dt.value)) {
+            zone = icaltimezone_get_utc_timezone();
+        } else if (dt.tzid && !*isDate) {
+            icaltimezone *tz = e_cal_client_resolve_tzid_cb(dt.tzid, client);
+            if (tz) {
+                zone = tz;
+                *tzId = QByteArray(dt.tzid);
+            }
+        }
+    }
+    e_cal_component_free_datetime(&dt);
+    return zone;
+}
+
+QString SeriesExpansion::exceptionKey(ECalClient *client, ECalComponent *comp)
+{
+    ECalComponentRange range;
+    e_cal_component_get_recurid(comp, &range);
+    if (!range.datetime.value) {
+        e_cal_component_free_range(&range);
+        return QString();
+    }
+
+    icaltimezone *zone = e_cal_client_get_default_timezone(client);
+    if (icaltime_is_utc(*range.datetime.value)) {
+        zone = icaltimezone_get_utc_timezone();
+    } else if (range.datetime.tzid && !icaltime_is_date(*range.datetime.value)) {
+        icaltimezone *tz = e_cal_client_resolve_tzid_cb(range.datetime.tzid, client);
+        if (tz) {
+            zone = tz;
+        }
+    }
+    time_t rid = icaltime_as_timet_with_zone(*range.datetime.value, zone);
+    e_cal_component_free_range(&range);
+
+    const gchar *uid = 0;
+    e_cal_component_get_uid(comp, &uid);
+    return QString("%1\n%2").arg(QString::fromUtf8(uid)).arg(qint64(rid));
+}
+
+QString SeriesExpansion::seriesQuery(const QStringList &uids)
+{
+    QString query("(or");
+    Q_FOREACH(QString uid, uids) {
+        uid.replace("\\", "\\\\").replace("\"", "\\\"");
+        query += QString(" (uid? \"%1\")").arg(uid);
+    }
+    query += ")";
+    return query;
+}
+
+SeriesExpansion *SeriesExpansion::expand(ECalClient *client,
+                                         ECalComponent *master,
+                                         time_t start,
+                                         time_t end,
+                                         const QSet<QString> &exceptions)
+{
+    SeriesExpansion *expansion = new SeriesExpansion(master);
+    const gchar *uid = 0;
+    e_cal_component_get_uid(master, &uid);
+    expansion->m_uid = QString::fromUtf8(uid);
+    expansion->m_zone = startZone(client, master, &expansion->m_tzId, &expansion->m_isDate);
+    expansion->m_exceptions = &exceptions;
+
+    e_cal_recur_generate_instances(master,
+                                   start,
+                                   end,
+                                   (ECalRecurInstanceFn) SeriesExpansion::onInstance,
+                                   expansion,
+                                   e_cal_client_resolve_tzid_cb,
+                                   client,
+                                   e_cal_client_get_default_timezone(client));
+
+    expansion->m_exceptions = 0;
+    return expansion;
+}
+
+gboolean SeriesExpansion::onInstance(ECalComponent *comp,
+                                     time_t instanceStart,
+                                     time_t instanceEnd,
+                                     SeriesExpansion *self)
+{
+    Q_UNUSED(comp);
+
+    // detached occurrences are returned as regular components
+    if (!self->m_exceptions->isEmpty() &&
+        self->m_exceptions->contains(QString("%1\n%2").arg(self->m_uid).arg(qint64(instanceStart)))) {
+        return TRUE;
+    }
+
+    Occurrence occurrence;
+    occurrence.start = icaltime_from_timet_with_zone(instanceStart, self->m_isDate, self->m_zone);
+    occurrence.end = icaltime_from_timet_with_zone(instanceEnd, self->m_isDate, self->m_zone);
+    self->m_occurrences << occurrence;
+    return TRUE;
+}
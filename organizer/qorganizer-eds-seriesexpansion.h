@@ -0,0 +1,76 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_SERIESEXPANSION_H__
+#define __QORGANIZER_EDS_SERIESEXPANSION_H__
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <libecal/libecal.h>
+
+// Occurrences of a recurrent component expanded in-process, only the start and end
+// of each occurrence is stored; items are built from the master when parsed
+class SeriesExpansion
+{
+public:
+    struct Occurrence
+    {
+        struct icaltimetype start;
+        struct icaltimetype end;
+    };
+
+    SeriesExpansion(ECalComponent *master);
+    ~SeriesExpansion();
+
+    ECalComponent *master() const;
+    QByteArray tzId() const;
+    const QVector<Occurrence> &occurrences() const;
+
+    static SeriesExpansion *expand(ECalClient *client,
+                                   ECalComponent *master,
+                                   time_t start,
+                                   time_t end,
+                                   const QSet<QString> &exceptions);
+    static QString exceptionKey(ECalClient *client, ECalComponent *comp);
+    // matches every component of the series, exceptions moved out of the interval included
+    static QString seriesQuery(const QStringList &uids);
+    static icaltimezone *startZone(ECalClient *client, ECalComponent *comp, QByteArray *tzId, bool *isDate);
+
+private:
+    ECalComponent *m_master;
+    QByteArray m_tzId;
+    QVector<Occurrence> m_occurrences;
+
+    // used while expanding
+    icaltimezone *m_zone;
+    bool m_isDate;
+    const QSet<QString> *m_exceptions;
+    QString m_uid;
+
+    static gboolean onInstance(ECalComponent *comp,
+                               time_t instanceStart,
+                               time_t instanceEnd,
+                               SeriesExpansion *self);
+
+    Q_DISABLE_COPY(SeriesExpansion)
+};
+
+#endif
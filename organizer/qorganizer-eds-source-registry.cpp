@@ -1,7 +1,10 @@
 #include "qorganizer-eds-source-registry.h"
+#include "qorganizer-eds-registrycache.h"
 #include "config.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
 #include <evolution-data-server-ubuntu/e-source-ubuntu.h>
 
 using namespace QtOrganizer;
@@ -11,6 +14,12 @@ static const QString DEFAULT_COLLECTION_SETTINGS("qtpim/default-colection");
 SourceRegistry::SourceRegistry(QObject *parent)
     : QObject(parent),
       m_sourceRegistry(0),
+      m_cancellable(0),
+      m_loadState(NotLoaded),
+      m_cache(0),
+      m_revisionsCancellable(0),
+      m_generation(1),
+      m_collectionsSnapshotGeneration(0),
       m_sourceAddedId(0),
       m_sourceRemovedId(0),
       m_sourceChangedId(0),
@@ -22,6 +31,17 @@ SourceRegistry::SourceRegistry(QObject *parent)
 
 SourceRegistry::~SourceRegistry()
 {
+    if (m_cancellable) {
+        g_cancellable_cancel(m_cancellable);
+        g_clear_object(&m_cancellable);
+    }
+
+    // store the collections changed while this process was running
+    if (m_cache && isLoaded()) {
+        saveCache();
+    }
+    delete m_cache;
+
     clear();
 
     if (m_sourceRegistry) {
@@ -44,20 +64,94 @@ ESourceRegistry *SourceRegistry::object() const
 
 void SourceRegistry::load()
 {
-    if (m_sourceRegistry) {
+    // a failed load is retried
+    if ((m_loadState == Loading) || m_sourceRegistry) {
         return;
     }
 
     clear();
 
+    if (m_cache) {
+        m_cache->load();
+    }
+
+    m_loadState = Loading;
+    m_cancellable = g_cancellable_new();
+    e_source_registry_new(m_cancellable,
+                          (GAsyncReadyCallback) SourceRegistry::onRegistryCreated,
+                          this);
+}
+
+bool SourceRegistry::isLoaded() const
+{
+    return (m_loadState == Loaded);
+}
+
+void SourceRegistry::setCacheFile(const QString &fileName)
+{
+    delete m_cache;
+    m_cache = fileName.isEmpty() ? 0 : new RegistryCache(fileName);
+}
+
+bool SourceRegistry::hasCachedCollections() const
+{
+    return (m_loadState == Loading) && m_cache && m_cache->isValid();
+}
+
+void SourceRegistry::saveCache()
+{
+    m_cache->save(collections(), m_defaultCollection.id());
+}
+
+bool SourceRegistry::waitForLoaded(int msecs)
+{
+    if (m_loadState != Loading) {
+        return true;
+    }
+
+    QEventLoop eventLoop;
+    connect(this, SIGNAL(loaded()), &eventLoop, SLOT(quit()));
+    if (msecs > 0) {
+        QTimer::singleShot(msecs, &eventLoop, SLOT(quit()));
+    }
+    eventLoop.exec();
+    return (m_loadState != Loading);
+}
+
+void SourceRegistry::onRegistryCreated(GObject *sourceObject,
+                                       GAsyncResult *res,
+                                       SourceRegistry *self)
+{
+    Q_UNUSED(sourceObject);
+
     GError *error = 0;
-    m_sourceRegistry = e_source_registry_new_sync(0, &error);
+    ESourceRegistry *registry = e_source_registry_new_finish(res, &error);
     if (error) {
+        // the registry was destroyed before the load finished
+        if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(error);
+            return;
+        }
         qWarning() << "Fail to create sourge registry:" << error->message;
         g_error_free(error);
-        return;
     }
 
+    // the live collections replace the cached ones from now on
+    g_clear_object(&self->m_cancellable);
+    self->m_loadState = Loaded;
+    if (registry) {
+        self->m_sourceRegistry = registry;
+        self->registerSources();
+        if (self->m_cache) {
+            self->saveCache();
+        }
+    }
+
+    Q_EMIT self->loaded();
+}
+
+void SourceRegistry::registerSources()
+{
     m_sourceAddedId = g_signal_connect(m_sourceRegistry,
                      "source-added",
                      (GCallback) SourceRegistry::onSourceAdded,
@@ -86,8 +180,8 @@ void SourceRegistry::load()
     QByteArray defaultId = defaultCollectionId();
     GList *sources = e_source_registry_list_sources(m_sourceRegistry, 0);
     bool foundDefault = false;
-    for(int i = 0, iMax = g_list_length(sources); i < iMax; i++) {
-        ESource *source = E_SOURCE(g_list_nth_data(sources, i));
+    for(GList *l = sources; l; l = l->next) {
+        ESource *source = E_SOURCE(l->data);
         bool isDefault = (g_strcmp0(defaultId.constData(), e_source_get_uid(source)) == 0);
         QOrganizerCollection collection = registerSource(source, isDefault);
 
@@ -97,7 +191,7 @@ void SourceRegistry::load()
         }
     }
 
-    if (!foundDefault) {
+    if (!foundDefault && !m_collections.isEmpty()) {
         //fallback to first collection
         m_defaultCollection = m_collections.first();
     }
@@ -107,6 +201,9 @@ void SourceRegistry::load()
 
 QtOrganizer::QOrganizerCollection SourceRegistry::defaultCollection() const
 {
+    if (hasCachedCollections()) {
+        return m_cache->defaultCollection();
+    }
     return m_defaultCollection;
 }
 
@@ -127,7 +224,27 @@ QOrganizerCollection SourceRegistry::collection(const QString &collectionId) con
 
 QList<QOrganizerCollection> SourceRegistry::collections() const
 {
-    return m_collections.values();
+    if (hasCachedCollections()) {
+        return m_cache->collections();
+    }
+
+    // shared with the callers until the next change
+    if (m_collectionsSnapshotGeneration != m_generation) {
+        m_collectionsSnapshot = m_collections.values();
+        m_collectionsSnapshotGeneration = m_generation;
+    }
+    return m_collectionsSnapshot;
+}
+
+quint64 SourceRegistry::generation() const
+{
+    return m_generation;
+}
+
+void SourceRegistry::collectionsChanged()
+{
+    m_generation++;
+    m_collectionsSnapshot.clear();
 }
 
 QStringList SourceRegistry::collectionsIds() const
@@ -175,13 +292,18 @@ void SourceRegistry::remove(const QString &collectionId)
 
     QOrganizerCollection collection = m_collections.take(collectionId);
     if (!collection.id().isNull()) {
+        collectionsChanged();
         Q_EMIT sourceRemoved(collectionId);
         m_collectionsMap.remove(collectionId);
-        g_object_unref(m_sources.take(collectionId));
+        ESource *source = m_sources.take(collectionId);
+        m_sourceUids.remove(QString::fromUtf8(e_source_get_uid(source)));
+        g_object_unref(source);
         EClient *client = m_clients.take(collectionId);
         if (client) {
+            g_signal_handlers_disconnect_by_data(client, this);
             g_object_unref(client);
         }
+        m_revisions.remove(collectionId);
     }
 
     // update default collection if necessary
@@ -212,9 +334,24 @@ EClient* SourceRegistry::client(const QString &collectionId)
                 if (e_client_is_readonly(client)) {
                     QOrganizerCollection &c = m_collections[collectionId];
                     c.setExtendedMetaData(COLLECTION_READONLY_METADATA, true);
+                    collectionsChanged();
                     Q_EMIT sourceUpdated(collectionId);
                 }
                 m_clients.insert(collectionId, client);
+
+                // the revision stays unknown until one of these reports it
+                g_signal_connect(client,
+                                 "backend-property-changed",
+                                 (GCallback) SourceRegistry::onClientPropertyChanged,
+                                 this);
+                if (!m_revisionsCancellable) {
+                    m_revisionsCancellable = g_cancellable_new();
+                }
+                e_client_get_backend_property(client,
+                                              CLIENT_BACKEND_PROPERTY_REVISION,
+                                              m_revisionsCancellable,
+                                              (GAsyncReadyCallback) SourceRegistry::onClientRevision,
+                                              this);
             }
         }
     }
@@ -226,30 +363,42 @@ EClient* SourceRegistry::client(const QString &collectionId)
 
 void SourceRegistry::clear()
 {
+    if (m_revisionsCancellable) {
+        g_cancellable_cancel(m_revisionsCancellable);
+        g_clear_object(&m_revisionsCancellable);
+    }
+
     Q_FOREACH(ESource *source, m_sources.values()) {
         g_object_unref(source);
     }
 
     Q_FOREACH(EClient *client, m_clients.values()) {
+        g_signal_handlers_disconnect_by_data(client, this);
         g_object_unref(client);
     }
 
     m_sources.clear();
+    m_sourceUids.clear();
     m_collections.clear();
     m_collectionsMap.clear();
+    collectionsChanged();
     m_clients.clear();
+    m_revisions.clear();
+}
+
+QString SourceRegistry::revision(const QString &collectionId) const
+{
+    return m_revisions.value(collectionId);
 }
 
 QString SourceRegistry::findCollection(ESource *source) const
 {
-    QMap<QString, ESource*>::ConstIterator i = m_sources.constBegin();
-    while (i != m_sources.constEnd()) {
-        if (e_source_equal(source, i.value())) {
-            return i.key();
-        }
-        i++;
+    // e_source_equal compares the source uids
+    const gchar *uid = e_source_get_uid(source);
+    if (!uid) {
+        return QString();
     }
-    return QString();
+    return m_sourceUids.value(QString::fromUtf8(uid));
 }
 
 QOrganizerCollection SourceRegistry::registerSource(ESource *source, bool isDefault)
@@ -271,8 +420,10 @@ QOrganizerCollection SourceRegistry::registerSource(ESource *source, bool isDefa
                 m_collections.insert(collectionId, collection);
                 m_collectionsMap.insert(collectionId, edsId);
                 m_sources.insert(collectionId, source);
+                m_sourceUids.insert(QString::fromUtf8(e_source_get_uid(source)), collectionId);
                 g_object_ref(source);
 
+                collectionsChanged();
                 Q_EMIT sourceAdded(collectionId);
             } else {
                 Q_ASSERT(false);
@@ -293,6 +444,7 @@ void SourceRegistry::updateDefaultCollection(QOrganizerCollection *collection)
 
         collection->setExtendedMetaData(COLLECTION_DEFAULT_METADATA, true);
         m_defaultCollection = *collection;
+        collectionsChanged();
         Q_EMIT sourceUpdated(m_defaultCollection.id().toString());
 
         if (m_collections.contains(oldDefaultCollectionId)) {
@@ -371,12 +523,52 @@ void SourceRegistry::onSourceChanged(ESourceRegistry *registry,
         self->updateCollection(&collection,
                                self->m_defaultCollection.id() == collection.id(),
                                source, self->m_clients.value(collectionId));
+        self->collectionsChanged();
         Q_EMIT self->sourceUpdated(collectionId);
     } else {
         qWarning() << "Source changed not found";
     }
 }
 
+void SourceRegistry::onClientPropertyChanged(EClient *client,
+                                             const gchar *propName,
+                                             const gchar *propValue,
+                                             SourceRegistry *self)
+{
+    if (g_strcmp0(propName, CLIENT_BACKEND_PROPERTY_REVISION) != 0) {
+        return;
+    }
+
+    QString collectionId = self->m_clients.key(client);
+    if (!collectionId.isEmpty()) {
+        self->m_revisions.insert(collectionId, QString::fromUtf8(propValue));
+    }
+}
+
+void SourceRegistry::onClientRevision(GObject *sourceObject,
+                                      GAsyncResult *res,
+                                      SourceRegistry *self)
+{
+    GError *error = 0;
+    gchar *revision = 0;
+    e_client_get_backend_property_finish(E_CLIENT(sourceObject), res, &revision, &error);
+    if (error) {
+        // canceled reads belong to a cleared registry, do not touch it
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            qWarning() << "Fail to read client revision" << error->message;
+        }
+        g_error_free(error);
+        return;
+    }
+
+    // a change notified meanwhile is newer than this answer
+    QString collectionId = self->m_clients.key(E_CLIENT(sourceObject));
+    if (!collectionId.isEmpty() && !self->m_revisions.contains(collectionId) && revision) {
+        self->m_revisions.insert(collectionId, QString::fromUtf8(revision));
+    }
+    g_free(revision);
+}
+
 void SourceRegistry::onSourceRemoved(ESourceRegistry *registry,
                                      ESource *source,
                                      SourceRegistry *self)
@@ -21,6 +21,7 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QSettings>
+#include <QtCore/QHash>
 
 #include <QtOrganizer/QOrganizerCollectionId>
 #include <QtOrganizer/QOrganizerCollection>
@@ -37,6 +38,8 @@
 #define COLLECTION_ACCOUNT_ID_METADATA      "collection-account-id"
 #define COLLECTION_DATA_METADATA            "collection-metadata"
 
+class RegistryCache;
+
 class SourceRegistry : public QObject
 {
     Q_OBJECT
@@ -45,11 +48,19 @@ public:
     ~SourceRegistry();
 
     ESourceRegistry *object() const;
+    // starts loading the sources in background, loaded() is emitted once done
     void load();
+    bool isLoaded() const;
+    // waits forever if msecs <= 0, returns false on timeout
+    bool waitForLoaded(int msecs = 0);
+    // keeps a copy of the collections on disk, to be used by the next load()
+    void setCacheFile(const QString &fileName);
+    bool hasCachedCollections() const;
     QtOrganizer::QOrganizerCollection defaultCollection() const;
     void setDefaultCollection(QtOrganizer::QOrganizerCollection &collection);
     QtOrganizer::QOrganizerCollection collection(const QString &collectionId) const;
     QList<QtOrganizer::QOrganizerCollection> collections() const;
+    quint64 generation() const;
     QStringList collectionsIds() const;
     QList<QOrganizerEDSCollectionEngineId*> collectionsEngineIds() const;
     ESource *source(const QString &collectionId) const;
@@ -59,6 +70,8 @@ public:
     void remove(ESource *source);
     void remove(const QString &collectionId);
     EClient *client(const QString &collectionId);
+    // backend revision of a connected collection
+    QString revision(const QString &collectionId) const;
     void clear();
 
     static QtOrganizer::QOrganizerCollection parseSource(ESource *source,
@@ -70,15 +83,34 @@ Q_SIGNALS:
     void sourceAdded(const QString &collectionId);
     void sourceRemoved(const QString &collectionId);
     void sourceUpdated(const QString &collectionId);
+    void loaded();
 
 private:
+    enum LoadState {
+        NotLoaded = 0,
+        Loading,
+        Loaded
+    };
+
     QSettings m_settings;
     ESourceRegistry *m_sourceRegistry;
+    GCancellable *m_cancellable;
+    LoadState m_loadState;
+    RegistryCache *m_cache;
     QtOrganizer::QOrganizerCollection m_defaultCollection;
     QMap<QString, EClient*> m_clients;
+    QHash<QString, QString> m_revisions;
+    // pending revision reads of the connected clients
+    GCancellable *m_revisionsCancellable;
     QMap<QString, ESource*> m_sources;
+    // source uid -> collection id, index for findCollection
+    QHash<QString, QString> m_sourceUids;
     QMap<QString, QtOrganizer::QOrganizerCollection> m_collections;
     QMap<QString, QOrganizerEDSCollectionEngineId*> m_collectionsMap;
+    // bumped on every collection change; the snapshot is rebuilt lazily
+    quint64 m_generation;
+    mutable quint64 m_collectionsSnapshotGeneration;
+    mutable QList<QtOrganizer::QOrganizerCollection> m_collectionsSnapshot;
 
     // handler id
     int m_sourceAddedId;
@@ -90,6 +122,9 @@ private:
 
     QByteArray defaultCollectionId() const;
     QString findCollection(ESource *source) const;
+    void registerSources();
+    void saveCache();
+    void collectionsChanged();
     QtOrganizer::QOrganizerCollection registerSource(ESource *source, bool isDefault = false);
     void updateDefaultCollection(QtOrganizer::QOrganizerCollection *collection);
     static void updateCollection(QtOrganizer::QOrganizerCollection *collection,
@@ -99,12 +134,22 @@ private:
 
 
     // glib callback
+    static void onRegistryCreated(GObject *sourceObject,
+                                  GAsyncResult *res,
+                                  SourceRegistry *self);
     static void onSourceAdded(ESourceRegistry *registry,
                               ESource *source,
                               SourceRegistry *self);
     static void onSourceChanged(ESourceRegistry *registry,
                                 ESource *source,
                                 SourceRegistry *self);
+    static void onClientPropertyChanged(EClient *client,
+                                        const gchar *propName,
+                                        const gchar *propValue,
+                                        SourceRegistry *self);
+    static void onClientRevision(GObject *sourceObject,
+                                 GAsyncResult *res,
+                                 SourceRegistry *self);
     static void onSourceRemoved(ESourceRegistry *registry,
                                 ESource *source,
                                 SourceRegistry *self);
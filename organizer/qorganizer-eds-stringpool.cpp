@@ -0,0 +1,163 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-stringpool.h"
+
+#include <QMutexLocker>
+#include <QVarLengthArray>
+
+// strings only referenced by the pool are released when the pool doubles in size
+#define STRING_POOL_MIN_PRUNE_SIZE 1024
+
+Q_GLOBAL_STATIC(StringPool, stringPool)
+
+StringPool::StringPool()
+    : m_pruneSize(STRING_POOL_MIN_PRUNE_SIZE),
+      m_savedBytes(0)
+{
+}
+
+StringPool *StringPool::instance()
+{
+    return stringPool();
+}
+
+QString StringPool::intern(const QString &value)
+{
+    if (value.isEmpty()) {
+        return value;
+    }
+
+    QMutexLocker locker(&m_lock);
+    QString pooled = lookupLocked(value);
+    if (!pooled.isNull()) {
+        return pooled;
+    }
+
+    insertLocked(value);
+    return value;
+}
+
+QString StringPool::intern(const QStringRef &value)
+{
+    if (value.isEmpty()) {
+        return QString();
+    }
+    return internRaw(value.unicode(), value.size());
+}
+
+QString StringPool::intern(const char *utf8)
+{
+    if (!utf8 || !*utf8) {
+        return QString::fromUtf8(utf8);
+    }
+
+    // uids and tags are mostly ascii, widen them on the stack so a string
+    // already in the pool costs no allocation
+    QVarLengthArray<QChar, 256> buffer;
+    for (const char *c = utf8; *c; c++) {
+        if (uchar(*c) >= 0x80) {
+            return intern(QString::fromUtf8(utf8));
+        }
+        buffer.append(QLatin1Char(*c));
+    }
+    return internRaw(buffer.constData(), buffer.size());
+}
+
+QString StringPool::internRaw(const QChar *data, int size)
+{
+    // the key does not own the data, only new strings are copied
+    const QString key = QString::fromRawData(data, size);
+
+    QMutexLocker locker(&m_lock);
+    QString pooled = lookupLocked(key);
+    if (!pooled.isNull()) {
+        return pooled;
+    }
+
+    QString value(data, size);
+    insertLocked(value);
+    return value;
+}
+
+QString StringPool::lookupLocked(const QString &key)
+{
+    QSet<QString>::const_iterator i = m_strings.constFind(key);
+    if (i == m_strings.constEnd()) {
+        return QString();
+    }
+    m_hits.ref();
+    m_savedBytes += i->size() * sizeof(QChar);
+    return *i;
+}
+
+void StringPool::insertLocked(const QString &value)
+{
+    // pruning under the same lock, a concurrent intern of the value can not
+    // insert a second copy in between
+    if (m_strings.size() >= m_pruneSize) {
+        pruneLocked();
+    }
+    m_strings.insert(value);
+}
+
+int StringPool::size()
+{
+    QMutexLocker locker(&m_lock);
+    return m_strings.size();
+}
+
+void StringPool::prune()
+{
+    QMutexLocker locker(&m_lock);
+    pruneLocked();
+}
+
+void StringPool::pruneLocked()
+{
+    QSet<QString>::iterator i = m_strings.begin();
+    while (i != m_strings.end()) {
+        // nobody else holds this string
+        if (i->isDetached()) {
+            i = m_strings.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    m_pruneSize = qMax(STRING_POOL_MIN_PRUNE_SIZE, m_strings.size() * 2);
+}
+
+int StringPool::hits() const
+{
+    return m_hits.load();
+}
+
+qint64 StringPool::savedBytes()
+{
+    QMutexLocker locker(&m_lock);
+    return m_savedBytes;
+}
+
+void StringPool::clear()
+{
+    QMutexLocker locker(&m_lock);
+    m_strings.clear();
+    m_pruneSize = STRING_POOL_MIN_PRUNE_SIZE;
+    m_savedBytes = 0;
+    m_hits.store(0);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_STRINGPOOL_H__
+#define __QORGANIZER_EDS_STRINGPOOL_H__
+
+#include <QSet>
+#include <QString>
+#include <QMutex>
+#include <QAtomicInt>
+
+// Keeps a single copy of strings that repeat across items (collection ids, uids, ...)
+// all functions are thread-safe
+class StringPool
+{
+public:
+    static StringPool *instance();
+
+    QString intern(const QString &value);
+    // the value is only copied if it is not in the pool yet
+    QString intern(const QStringRef &value);
+    QString intern(const char *utf8);
+    int size();
+    void prune();
+
+    // number of lookups answered by an existing string
+    int hits() const;
+    // bytes not allocated thanks to the shared strings
+    qint64 savedBytes();
+    void clear();
+
+    StringPool();
+
+private:
+    QMutex m_lock;
+    QSet<QString> m_strings;
+    int m_pruneSize;
+    qint64 m_savedBytes;
+    QAtomicInt m_hits;
+
+    // m_lock must be held by the caller of these
+    QString lookupLocked(const QString &key);
+    void insertLocked(const QString &value);
+    void pruneLocked();
+    QString internRaw(const QChar *data, int size);
+
+    Q_DISABLE_COPY(StringPool)
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qorganizer-eds-timezonecache.h"
+
+#include <QReadLocker>
+#include <QWriteLocker>
+
+// how long (ms) the system timezone is trusted before we ask Qt again
+#define SYSTEM_TIMEZONE_TIMEOUT 1000
+
+Q_GLOBAL_STATIC(TimeZoneCache, timeZoneCache)
+
+TimeZoneCache::TimeZoneCache()
+    : m_utcZone("UTC")
+{
+}
+
+TimeZoneCache *TimeZoneCache::instance()
+{
+    return timeZoneCache();
+}
+
+TimeZoneCache::Zone TimeZoneCache::zone(const char *tzId)
+{
+    QByteArray key(tzId);
+    {
+        QReadLocker locker(&m_lock);
+        QHash<QByteArray, Zone>::const_iterator i = m_zones.constFind(key);
+        if (i != m_zones.constEnd()) {
+            m_hits.ref();
+            return i.value();
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    // other thread could have added it while we wait for the lock
+    QHash<QByteArray, Zone>::const_iterator i = m_zones.constFind(key);
+    if (i != m_zones.constEnd()) {
+        m_hits.ref();
+        return i.value();
+    }
+
+    m_misses.ref();
+    Zone z;
+    z.tzIdZone = icaltimezone_get_builtin_timezone_from_tzid(tzId);
+    z.zone = z.tzIdZone;
+    // fallback: sometimes the tzId contains the location name
+    if (!z.zone) {
+        z.zone = icaltimezone_get_builtin_timezone(tzId);
+    }
+    z.qtZone = QTimeZone(QByteArray(icaltimezone_get_location(z.zone)));
+    m_zones.insert(key, z);
+    return z;
+}
+
+icaltimezone *TimeZoneCache::builtinTimezone(const QByteArray &location)
+{
+    {
+        QReadLocker locker(&m_lock);
+        QHash<QByteArray, icaltimezone*>::const_iterator i = m_builtinZones.constFind(location);
+        if (i != m_builtinZones.constEnd()) {
+            m_hits.ref();
+            return i.value();
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    QHash<QByteArray, icaltimezone*>::const_iterator i = m_builtinZones.constFind(location);
+    if (i != m_builtinZones.constEnd()) {
+        m_hits.ref();
+        return i.value();
+    }
+
+    m_misses.ref();
+    icaltimezone *timezone = icaltimezone_get_builtin_timezone(location.constData());
+    m_builtinZones.insert(location, timezone);
+    return timezone;
+}
+
+QTimeZone TimeZoneCache::systemTimeZone()
+{
+    {
+        QReadLocker locker(&m_lock);
+        if (m_systemZoneAge.isValid() &&
+            !m_systemZoneAge.hasExpired(SYSTEM_TIMEZONE_TIMEOUT)) {
+            m_hits.ref();
+            return m_systemZone;
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    if (m_systemZoneAge.isValid() &&
+        !m_systemZoneAge.hasExpired(SYSTEM_TIMEZONE_TIMEOUT)) {
+        m_hits.ref();
+        return m_systemZone;
+    }
+
+    m_misses.ref();
+    m_systemZone = QTimeZone(QTimeZone::systemTimeZoneId());
+    m_systemZoneAge.start();
+    return m_systemZone;
+}
+
+QTimeZone TimeZoneCache::utcTimeZone() const
+{
+    return m_utcZone;
+}
+
+int TimeZoneCache::hits() const
+{
+    return m_hits.load();
+}
+
+int TimeZoneCache::misses() const
+{
+    return m_misses.load();
+}
+
+void TimeZoneCache::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_zones.clear();
+    m_builtinZones.clear();
+    m_systemZoneAge.invalidate();
+    m_hits.store(0);
+    m_misses.store(0);
+}
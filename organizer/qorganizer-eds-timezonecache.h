@@ -0,0 +1,73 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of canonical-pim-service
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __QORGANIZER_EDS_TIMEZONECACHE_H__
+#define __QORGANIZER_EDS_TIMEZONECACHE_H__
+
+#include <QHash>
+#include <QByteArray>
+#include <QTimeZone>
+#include <QReadWriteLock>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+#include <libecal/libecal.h>
+
+// Shared by the engine and the parse threads, all functions are thread-safe
+class TimeZoneCache
+{
+public:
+    struct Zone
+    {
+        Zone() : tzIdZone(0), zone(0) {}
+
+        // zone returned by icaltimezone_get_builtin_timezone_from_tzid
+        icaltimezone *tzIdZone;
+        // same as above but falling back to the location name lookup
+        icaltimezone *zone;
+        // Qt timezone for the location of "zone"
+        QTimeZone qtZone;
+    };
+
+    static TimeZoneCache *instance();
+
+    Zone zone(const char *tzId);
+    icaltimezone *builtinTimezone(const QByteArray &location);
+    QTimeZone systemTimeZone();
+    QTimeZone utcTimeZone() const;
+
+    int hits() const;
+    int misses() const;
+    void clear();
+
+    TimeZoneCache();
+
+private:
+    QReadWriteLock m_lock;
+    QHash<QByteArray, Zone> m_zones;
+    QHash<QByteArray, icaltimezone*> m_builtinZones;
+    QTimeZone m_utcZone;
+    QTimeZone m_systemZone;
+    QElapsedTimer m_systemZoneAge;
+    QAtomicInt m_hits;
+    QAtomicInt m_misses;
+
+    Q_DISABLE_COPY(TimeZoneCache)
+};
+
+#endif
@@ -20,6 +20,11 @@
 #include "qorganizer-eds-viewwatcher.h"
 #include "qorganizer-eds-fetchrequestdata.h"
 #include "qorganizer-eds-engineid.h"
+#include "qorganizer-eds-recurrencecache.h"
+#include "qorganizer-eds-alarmindex.h"
+#include "qorganizer-eds-changejournal.h"
+#include "qorganizer-eds-source-registry.h"
+#include "qorganizer-eds-metrics.h"
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
@@ -39,6 +44,7 @@ ViewWatcher::ViewWatcher(const QString &collectionId,
       m_eView(0),
       m_eventLoop(0)
 {
+    EngineMetrics::instance()->viewWatcherCreated();
     g_object_ref(m_eClient);
     m_cancellable = g_cancellable_new();
     e_cal_client_get_view(m_eClient,
@@ -54,6 +60,7 @@ ViewWatcher::ViewWatcher(const QString &collectionId,
 ViewWatcher::~ViewWatcher()
 {
     clear();
+    EngineMetrics::instance()->viewWatcherDestroyed();
 }
 
 void ViewWatcher::viewReady(GObject *sourceObject, GAsyncResult *res, ViewWatcher *self)
@@ -85,7 +92,16 @@ void ViewWatcher::viewReady(GObject *sourceObject, GAsyncResult *res, ViewWatche
                          "objects-modified",
                          (GCallback) ViewWatcher::onObjectsModified,
                          self);
+
+        g_signal_connect(view,
+                         "complete",
+                         (GCallback) ViewWatcher::onViewComplete,
+                         self);
         e_cal_client_view_set_flags(view, E_CAL_CLIENT_VIEW_FLAGS_NONE, NULL);
+        // every notification from now on is recorded, including the initial
+        // listing, so nothing changed before the view completes is lost
+        self->m_engineData->m_changeJournal->reset(self->m_collectionId,
+                                                   self->m_engineData->m_sourceRegistry->revision(self->m_collectionId));
         e_cal_client_view_start(view, &gError);
         if (gError) {
             qWarning() << "Fail to start view ("
@@ -134,6 +150,11 @@ void ViewWatcher::wait()
     }
 }
 
+ECalClient *ViewWatcher::client() const
+{
+    return m_eClient;
+}
+
 QList<QOrganizerItemId> ViewWatcher::parseItemIds(GSList *objects)
 {
     QList<QOrganizerItemId> result;
@@ -160,8 +181,20 @@ void ViewWatcher::notify()
     m_dirty.start(500);
 }
 
+void ViewWatcher::journal(QOrganizerManager::Operation operation,
+                          const QList<QOrganizerItemId> &itemIds)
+{
+    m_engineData->m_changeJournal->record(m_collectionId,
+                                          m_engineData->m_sourceRegistry->revision(m_collectionId),
+                                          operation,
+                                          itemIds);
+}
+
 void ViewWatcher::flush()
 {
+    EngineMetrics::instance()->addChangeSet(m_changeSet.addedItems().size() +
+                                            m_changeSet.changedItems().size() +
+                                            m_changeSet.removedItems().size());
     m_engineData->emitSharedSignals(&m_changeSet);
     m_changeSet.clearAll();
 }
@@ -171,7 +204,10 @@ void ViewWatcher::onObjectsAdded(ECalClientView *view,
                                  ViewWatcher *self)
 {
     Q_UNUSED(view);
-    self->m_changeSet.insertAddedItems(self->parseItemIds(objects));
+    self->m_engineData->m_alarmIndex->updateComponents(self->m_collectionId, self->m_eClient, objects);
+    QList<QOrganizerItemId> itemIds = self->parseItemIds(objects);
+    self->journal(QOrganizerManager::Add, itemIds);
+    self->m_changeSet.insertAddedItems(itemIds);
     self->notify();
 }
 
@@ -181,12 +217,17 @@ void ViewWatcher::onObjectsRemoved(ECalClientView *view,
 {
     Q_UNUSED(view);
 
+    QList<QOrganizerItemId> itemIds;
     for (GSList *l = objects; l; l = l->next) {
         ECalComponentId *id = static_cast<ECalComponentId*>(l->data);
+        RecurrenceCache::instance()->remove(self->m_collectionId, QString::fromUtf8(id->uid));
         QOrganizerEDSEngineId *itemId = new QOrganizerEDSEngineId(self->m_collectionId,
                                                                   QString::fromUtf8(id->uid));
-        self->m_changeSet.insertRemovedItem(QOrganizerItemId(itemId));
+        itemIds << QOrganizerItemId(itemId);
     }
+    self->journal(QOrganizerManager::Remove, itemIds);
+    self->m_changeSet.insertRemovedItems(itemIds);
+    self->m_engineData->m_alarmIndex->removeComponents(self->m_collectionId, self->m_eClient, objects);
     self->notify();
 }
 
@@ -196,6 +237,26 @@ void ViewWatcher::onObjectsModified(ECalClientView *view,
 {
     Q_UNUSED(view);
 
-    self->m_changeSet.insertChangedItems(self->parseItemIds(objects));
+    RecurrenceCache *cache = RecurrenceCache::instance();
+    for (GSList *l = objects; l; l = l->next) {
+        const char *uid = icalcomponent_get_uid(static_cast<icalcomponent*>(l->data));
+        cache->remove(self->m_collectionId, QString::fromUtf8(uid));
+    }
+    self->m_engineData->m_alarmIndex->updateComponents(self->m_collectionId, self->m_eClient, objects);
+    QList<QOrganizerItemId> itemIds = self->parseItemIds(objects);
+    self->journal(QOrganizerManager::Change, itemIds);
+    self->m_changeSet.insertChangedItems(itemIds);
     self->notify();
 }
+
+void ViewWatcher::onViewComplete(ECalClientView *view,
+                                 const GError *error,
+                                 ViewWatcher *self)
+{
+    Q_UNUSED(view);
+    if (error) {
+        qWarning() << "View failed to list the objects ("
+                   << self->m_collectionId << "):"
+                   << error->message;
+    }
+}
@@ -40,6 +40,7 @@ public:
     virtual ~ViewWatcher();
     void clear();
     void wait();
+    ECalClient *client() const;
 
 private Q_SLOTS:
     void flush();
@@ -56,6 +57,8 @@ private:
 
     QList<QtOrganizer::QOrganizerItemId> parseItemIds(GSList *objects);
     void notify();
+    void journal(QtOrganizer::QOrganizerManager::Operation operation,
+                 const QList<QtOrganizer::QOrganizerItemId> &itemIds);
 
 
     static void clientConnected(GObject *sourceObject, GAsyncResult *res, ViewWatcher *self);
@@ -64,6 +67,7 @@ private:
     static void onObjectsAdded(ECalClientView *view, GSList *objects, ViewWatcher *self);
     static void onObjectsRemoved(ECalClientView *view, GSList *objects, ViewWatcher *self);
     static void onObjectsModified(ECalClientView *view, GSList *objects, ViewWatcher *self);
+    static void onViewComplete(ECalClientView *view, const GError *error, ViewWatcher *self);
 };
 
 #endif
@@ -230,6 +230,82 @@ private Q_SLOTS:
         QCOMPARE(newCollection.extendedMetaData("collection-selected").toBool(), true);
     }
 
+    void testCollectionsSnapshot()
+    {
+        QtOrganizer::QOrganizerManager::Error error;
+
+        // without changes the same list is handed out
+        quint64 generation = m_engineRead->collectionsGeneration();
+        QList<QOrganizerCollection> first = m_engineRead->collections(&error);
+        QCOMPARE(error, QOrganizerManager::NoError);
+        QList<QOrganizerCollection> second = m_engineRead->collections(&error);
+        QVERIFY(first.isSharedWith(second));
+        QCOMPARE(m_engineRead->collectionsGeneration(), generation);
+
+        QOrganizerCollection collection;
+        collection.setMetaData(QOrganizerCollection::KeyName, uniqueCollectionName());
+        collection.setMetaData(QOrganizerCollection::KeyColor, QStringLiteral("red"));
+
+        QSignalSpy createCollection(m_engineRead, SIGNAL(collectionsAdded(QList<QOrganizerCollectionId>)));
+        QVERIFY(m_engineWrite->saveCollection(&collection, &error));
+        QTRY_COMPARE(createCollection.count(), 1);
+
+        // a new collection invalidates the snapshot
+        QVERIFY(m_engineRead->collectionsGeneration() != generation);
+        QList<QOrganizerCollection> third = m_engineRead->collections(&error);
+        QVERIFY(!third.isSharedWith(first));
+        QCOMPARE(third.count(), first.count() + 1);
+        QVERIFY(containsCollection(third, collection));
+        QCOMPARE(first.count(), second.count());
+
+        // and so does an update
+        QTRY_VERIFY_WITH_TIMEOUT(!m_engineRead->collection(collection.id(), 0).extendedMetaData("collection-readonly").toBool(), 5000);
+        generation = m_engineRead->collectionsGeneration();
+        QSignalSpy updateCollection(m_engineRead, SIGNAL(collectionsChanged(QList<QOrganizerCollectionId>)));
+        collection.setMetaData(QOrganizerCollection::KeyColor, QStringLiteral("blue"));
+        QVERIFY(m_engineWrite->saveCollection(&collection, &error));
+        QTRY_VERIFY(updateCollection.count() > 0);
+        QVERIFY(m_engineRead->collectionsGeneration() != generation);
+    }
+
+    void testUpdateManyCollections()
+    {
+        QList<QOrganizerCollection> collections;
+        QtOrganizer::QOrganizerManager::Error error;
+        for(int i = 0; i < 5; i++) {
+            QOrganizerCollection collection;
+            collection.setMetaData(QOrganizerCollection::KeyName, uniqueCollectionName());
+            collection.setMetaData(QOrganizerCollection::KeyColor, QStringLiteral("red"));
+            QVERIFY(m_engineWrite->saveCollection(&collection, &error));
+            QVERIFY(!collection.id().isNull());
+            collections << collection;
+        }
+
+        Q_FOREACH(const QOrganizerCollection &collection, collections) {
+            QTRY_VERIFY_WITH_TIMEOUT(!m_engineRead->collection(collection.id(), 0).extendedMetaData("collection-readonly").toBool(), 5000);
+        }
+
+        // all collections are written at once, results must keep the request order
+        static const QStringList colors = QStringList() << "blue" << "green" << "yellow" << "black" << "white";
+        for(int i = 0; i < collections.size(); i++) {
+            collections[i].setMetaData(QOrganizerCollection::KeyColor, colors[i]);
+        }
+
+        QOrganizerCollectionSaveRequest req;
+        req.setCollections(collections);
+        m_engineWrite->startRequest(&req);
+        m_engineWrite->waitForRequestFinished(&req, 0);
+
+        QCOMPARE(req.error(), QOrganizerManager::NoError);
+        QVERIFY(req.errorMap().isEmpty());
+        QList<QOrganizerCollection> saved = req.collections();
+        QCOMPARE(saved.size(), collections.size());
+        for(int i = 0; i < saved.size(); i++) {
+            QCOMPARE(saved[i].id(), collections[i].id());
+            QCOMPARE(saved[i].metaData(QOrganizerCollection::KeyColor).toString(), colors[i]);
+        }
+    }
+
     void testCreateTaskList()
     {
         static const QString collectionName = uniqueCollectionName() + QStringLiteral("_TASKS") ;
@@ -286,6 +362,36 @@ private Q_SLOTS:
         QVERIFY(!containsCollection(collections, collection));
     }
 
+    void testRemoveManyCollections()
+    {
+        QtOrganizer::QOrganizerManager::Error error;
+        int initalCollectionCount = m_engineRead->collections(&error).count();
+
+        QList<QOrganizerCollectionId> ids;
+        for(int i = 0; i < 4; i++) {
+            QOrganizerCollection collection;
+            collection.setMetaData(QOrganizerCollection::KeyName, uniqueCollectionName());
+            QVERIFY(m_engineWrite->saveCollection(&collection, &error));
+            QTRY_VERIFY_WITH_TIMEOUT(!m_engineRead->collection(collection.id(), 0).extendedMetaData("collection-readonly").toBool(), 5000);
+            ids << collection.id();
+        }
+        // an invalid collection in the middle must not stop the others
+        ids.insert(2, QOrganizerCollectionId::fromString(QStringLiteral("qtorganizer:eds::invalid-collection")));
+
+        QOrganizerCollectionRemoveRequest req;
+        req.setCollectionIds(ids);
+        m_engineWrite->startRequest(&req);
+        m_engineWrite->waitForRequestFinished(&req, 0);
+
+        QCOMPARE(req.error(), QOrganizerManager::InvalidCollectionError);
+        QCOMPARE(req.errorMap().size(), 1);
+        QCOMPARE(req.errorMap().value(2), QOrganizerManager::InvalidCollectionError);
+
+        QTRY_COMPARE(m_engineRead->collections(&error).count(), initalCollectionCount);
+        QList<QOrganizerCollection> collections = m_engineWrite->collections(&error);
+        QCOMPARE(collections.count(), initalCollectionCount);
+    }
+
     void testReadOnlyCollection()
     {
         // check if the anniversaries collection is read-only
@@ -464,6 +570,90 @@ private Q_SLOTS:
         QOrganizerCollection newCollection = m_engineRead->collection(collection.id(), 0);
         QCOMPARE(newCollection.extendedMetaData(COLLECTION_DATA_METADATA).toString(), metadataValue);
     }
+
+    void testLoadSourceRegistry()
+    {
+        SourceRegistry registry;
+        QSignalSpy loaded(&registry, SIGNAL(loaded()));
+
+        // load returns before the sources are known
+        registry.load();
+        QVERIFY(!registry.isLoaded());
+
+        QTRY_COMPARE(loaded.count(), 1);
+        QVERIFY(registry.isLoaded());
+        QVERIFY(registry.object());
+        QCOMPARE(registry.collections().count(), m_engineRead->collections(0).count());
+        QVERIFY(!registry.defaultCollection().id().isNull());
+    }
+
+    void testRegistryWarmStartCache()
+    {
+        QTemporaryDir cacheDir;
+        const QString cacheFile = cacheDir.path() + QStringLiteral("/collections.cache");
+
+        QList<QOrganizerCollection> collections;
+        QOrganizerCollection defaultCollection;
+        {
+            // nothing cached yet, the file is written once loaded
+            SourceRegistry registry;
+            registry.setCacheFile(cacheFile);
+            registry.load();
+            QVERIFY(!registry.hasCachedCollections());
+            registry.waitForLoaded();
+            QVERIFY(QFile::exists(cacheFile));
+            collections = registry.collections();
+            defaultCollection = registry.defaultCollection();
+        }
+
+        SourceRegistry registry;
+        registry.setCacheFile(cacheFile);
+        registry.load();
+        QVERIFY(!registry.isLoaded());
+        QVERIFY(registry.hasCachedCollections());
+
+        // served from the cache while the registry loads
+        QList<QOrganizerCollection> cached = registry.collections();
+        QCOMPARE(cached.count(), collections.count());
+        for(int i = 0; i < cached.count(); i++) {
+            QCOMPARE(cached[i].id(), collections[i].id());
+            QCOMPARE(cached[i].metaData(QOrganizerCollection::KeyName),
+                     collections[i].metaData(QOrganizerCollection::KeyName));
+            QCOMPARE(cached[i].extendedMetaData(COLLECTION_CALLENDAR_TYPE_METADATA),
+                     collections[i].extendedMetaData(COLLECTION_CALLENDAR_TYPE_METADATA));
+        }
+        QCOMPARE(registry.defaultCollection().id(), defaultCollection.id());
+
+        registry.waitForLoaded();
+        QVERIFY(!registry.hasCachedCollections());
+        QCOMPARE(registry.collections().count(), collections.count());
+    }
+
+    void testRequestBeforeRegistryLoaded()
+    {
+        // drop the shared engine data, the next engine loads a new registry
+        delete m_engineRead;
+        delete m_engineWrite;
+        m_engineRead = QOrganizerEDSEngine::createEDSEngine(QMap<QString, QString>());
+
+        QOrganizerCollectionFetchRequest req;
+        m_engineRead->startRequest(&req);
+        QCOMPARE(req.state(), QOrganizerAbstractRequest::ActiveState);
+        m_engineRead->waitForRequestFinished(&req, 0);
+        QCOMPARE(req.state(), QOrganizerAbstractRequest::FinishedState);
+        QVERIFY(req.collections().count() > 0);
+
+        m_engineWrite = QOrganizerEDSEngine::createEDSEngine(QMap<QString, QString>());
+    }
+
+    void benchmarkLoadSourceRegistry()
+    {
+        QBENCHMARK {
+            SourceRegistry registry;
+            registry.load();
+            registry.waitForLoaded();
+        }
+    }
 };
 
 const QString CollectionTest::collectionTypePropertyName = QStringLiteral("collection-type");
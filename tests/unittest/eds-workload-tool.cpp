@@ -0,0 +1,100 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of ubuntu-pim-service.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "eds-workload.h"
+#include "qorganizer-eds-engine.h"
+
+#include <QtCore>
+
+#include <stdio.h>
+
+using namespace QtOrganizer;
+
+// Populates the running EDS instance (or prints the iCalendar data with
+// --dump) with a generated workload, e.g. inside run-eds-test.sh
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("eds-workload-tool");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates reproducible calendars for performance tests");
+    parser.addHelpOption();
+
+    QCommandLineOption seedOption("seed", "Random seed.", "n", "1");
+    QCommandLineOption collectionsOption("collections", "Number of collections.", "n", "1");
+    QCommandLineOption eventsOption("events", "Events per collection.", "n", "100");
+    QCommandLineOption recurringOption("recurring", "Share of recurring events (0-1).", "ratio", "0.2");
+    QCommandLineOption exceptionsOption("exceptions", "Chance of an occurrence to be detached (0-1).", "ratio", "0.05");
+    QCommandLineOption occurrencesOption("occurrences", "Maximum occurrences of a recurring event.", "n", "20");
+    QCommandLineOption attendeesOption("attendees", "Maximum attendees per event.", "n", "3");
+    QCommandLineOption alarmsOption("alarms", "Maximum alarms per event.", "n", "1");
+    QCommandLineOption descriptionOption("description-size", "Description length in characters.", "n", "200");
+    QCommandLineOption spanOption("span", "Days covered by the events.", "days", "365");
+    QCommandLineOption dumpOption("dump", "Print the calendars instead of storing them in EDS.");
+    parser.addOptions(QList<QCommandLineOption>() << seedOption << collectionsOption << eventsOption
+                      << recurringOption << exceptionsOption << occurrencesOption << attendeesOption
+                      << alarmsOption << descriptionOption << spanOption << dumpOption);
+    parser.process(app);
+
+    EDSWorkload::Parameters parameters;
+    parameters.seed = parser.value(seedOption).toUInt();
+    parameters.collections = parser.value(collectionsOption).toInt();
+    parameters.eventsPerCollection = parser.value(eventsOption).toInt();
+    parameters.recurringRatio = parser.value(recurringOption).toDouble();
+    parameters.exceptionDensity = parser.value(exceptionsOption).toDouble();
+    parameters.maxOccurrences = parser.value(occurrencesOption).toInt();
+    parameters.maxAttendees = parser.value(attendeesOption).toInt();
+    parameters.maxAlarms = parser.value(alarmsOption).toInt();
+    parameters.descriptionSize = parser.value(descriptionOption).toInt();
+    parameters.spanDays = parser.value(spanOption).toInt();
+
+    EDSWorkload workload(parameters);
+    if (parser.isSet(dumpOption)) {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        for(int c = 0; c < parameters.collections; c++) {
+            out.write(workload.calendar(c));
+        }
+    } else {
+        QCoreApplication::addLibraryPath(QORGANIZER_DEV_PATH);
+        QOrganizerEDSEngine *engine = QOrganizerEDSEngine::createEDSEngine(QMap<QString, QString>());
+        QOrganizerManager::Error error = QOrganizerManager::NoError;
+        QElapsedTimer timer;
+        timer.start();
+        QList<QOrganizerCollection> collections = workload.populate(engine, &error);
+        qint64 elapsed = timer.elapsed();
+        delete engine;
+
+        if (error != QOrganizerManager::NoError) {
+            qWarning() << "Fail to populate EDS:" << error;
+            return 1;
+        }
+        Q_FOREACH(const QOrganizerCollection &collection, collections) {
+            fprintf(stdout, "%s\n", qPrintable(collection.id().toString()));
+        }
+        fprintf(stderr, "populated in %lld ms\n", elapsed);
+    }
+
+    EDSWorkload::Statistics statistics = workload.statistics();
+    fprintf(stderr, "events: %d recurring: %d exceptions: %d attendees: %d alarms: %d bytes: %lld\n",
+            statistics.events, statistics.recurringEvents, statistics.exceptions,
+            statistics.attendees, statistics.alarms, statistics.bytes);
+    return 0;
+}
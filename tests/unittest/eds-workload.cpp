@@ -0,0 +1,271 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of ubuntu-pim-service.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "eds-workload.h"
+#include "qorganizer-eds-engine.h"
+
+#include <QtCore>
+
+#include <libical/ical.h>
+
+using namespace QtOrganizer;
+
+static const char *WORKLOAD_WORDS[] = {
+    "meeting", "project", "review", "lunch", "call", "planning", "budget",
+    "release", "design", "team", "office", "travel", "customer", "report",
+    "schedule", "weekly", "notes", "agenda", "room", "follow", "up", 0
+};
+
+EDSWorkload::Parameters::Parameters()
+    : seed(1),
+      collections(1),
+      eventsPerCollection(100),
+      recurringRatio(0.2),
+      exceptionDensity(0.05),
+      maxOccurrences(20),
+      maxAttendees(3),
+      maxAlarms(1),
+      descriptionSize(200),
+      start(QDate(2030, 1, 1), QTime(8, 0, 0), Qt::UTC),
+      spanDays(365)
+{
+}
+
+EDSWorkload::Statistics::Statistics()
+    : events(0),
+      recurringEvents(0),
+      exceptions(0),
+      attendees(0),
+      alarms(0),
+      bytes(0)
+{
+}
+
+EDSWorkload::EDSWorkload(const Parameters &parameters)
+    : m_parameters(parameters)
+{
+}
+
+EDSWorkload::Parameters EDSWorkload::parameters() const
+{
+    return m_parameters;
+}
+
+EDSWorkload::Statistics EDSWorkload::statistics() const
+{
+    Statistics total;
+    Q_FOREACH(const Statistics &statistics, m_statistics) {
+        total.events += statistics.events;
+        total.recurringEvents += statistics.recurringEvents;
+        total.exceptions += statistics.exceptions;
+        total.attendees += statistics.attendees;
+        total.alarms += statistics.alarms;
+        total.bytes += statistics.bytes;
+    }
+    return total;
+}
+
+quint32 EDSWorkload::next(quint32 bound)
+{
+    return (bound > 0) ? (m_random() % bound) : 0;
+}
+
+bool EDSWorkload::chance(double probability)
+{
+    return (m_random() / 4294967296.0) < probability;
+}
+
+QByteArray EDSWorkload::calendar(int collectionIndex)
+{
+    // each collection has its own sequence, so it can be generated alone
+    m_random.seed(m_parameters.seed + quint32(collectionIndex) * 2654435761u);
+
+    Statistics statistics;
+    QByteArray data;
+    appendLine(&data, QStringLiteral("BEGIN:VCALENDAR"));
+    appendLine(&data, QStringLiteral("VERSION:2.0"));
+    appendLine(&data, QStringLiteral("PRODID:-//qtorganizer5-eds//workload//EN"));
+    for(int i = 0; i < m_parameters.eventsPerCollection; i++) {
+        appendEvent(&data, &statistics, collectionIndex, i);
+    }
+    appendLine(&data, QStringLiteral("END:VCALENDAR"));
+
+    statistics.bytes = data.size();
+    m_statistics.insert(collectionIndex, statistics);
+    return data;
+}
+
+QList<QOrganizerCollection> EDSWorkload::populate(QOrganizerEDSEngine *engine,
+                                                  QOrganizerManager::Error *error)
+{
+    QList<QOrganizerCollection> collections;
+    m_statistics.clear();
+
+    for(int c = 0; c < m_parameters.collections; c++) {
+        QOrganizerCollection collection;
+        collection.setMetaData(QOrganizerCollection::KeyName,
+                               QString("workload-%1-%2").arg(m_parameters.seed).arg(c));
+        if (!engine->saveCollection(&collection, error)) {
+            return collections;
+        }
+
+        // wait for the registry to list the new source
+        QElapsedTimer timer;
+        timer.start();
+        while (engine->collection(collection.id(), 0).id().isNull() && (timer.elapsed() < 10000)) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+        }
+
+        QByteArray data = calendar(c);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QMap<int, QOrganizerManager::Error> errorMap;
+        if (!engine->importItems(&buffer, collection.id(), &errorMap, error)) {
+            qWarning() << "Fail to import workload" << errorMap;
+            return collections;
+        }
+        collections << collection;
+    }
+
+    if (error) {
+        *error = QOrganizerManager::NoError;
+    }
+    return collections;
+}
+
+QString EDSWorkload::description()
+{
+    int words = 0;
+    while (WORKLOAD_WORDS[words]) {
+        words++;
+    }
+
+    QString text;
+    while (text.size() < m_parameters.descriptionSize) {
+        if (!text.isEmpty()) {
+            text += QLatin1Char(' ');
+        }
+        text += QString::fromLatin1(WORKLOAD_WORDS[next(words)]);
+    }
+    return text.left(m_parameters.descriptionSize);
+}
+
+void EDSWorkload::appendEvent(QByteArray *data, Statistics *statistics, int collectionIndex, int eventIndex)
+{
+    const QString uid = QString("workload-%1-%2-%3").arg(m_parameters.seed).arg(collectionIndex).arg(eventIndex);
+    QDateTime start = m_parameters.start.addDays(next(qMax(m_parameters.spanDays, 1)))
+                                        .addSecs(next(12) * 30 * 60);
+    int duration = (1 + next(4)) * 30 * 60;
+
+    bool recurring = chance(m_parameters.recurringRatio);
+    static const char *frequencies[] = { "DAILY", "WEEKLY", "MONTHLY" };
+    int frequency = next(3);
+    int occurrences = 2 + next(qMax(m_parameters.maxOccurrences - 1, 1));
+    int attendees = next(m_parameters.maxAttendees + 1);
+    int alarms = next(m_parameters.maxAlarms + 1);
+    QString text = description();
+
+    appendLine(data, QStringLiteral("BEGIN:VEVENT"));
+    appendLine(data, QStringLiteral("UID:") + uid);
+    appendLine(data, QStringLiteral("DTSTAMP:") + formatDateTime(m_parameters.start));
+    appendLine(data, QStringLiteral("DTSTART:") + formatDateTime(start));
+    appendLine(data, QStringLiteral("DTEND:") + formatDateTime(start.addSecs(duration)));
+    appendLine(data, QString("SUMMARY:Workload event %1.%2").arg(collectionIndex).arg(eventIndex));
+    if (!text.isEmpty()) {
+        appendLine(data, QStringLiteral("DESCRIPTION:") + text);
+    }
+    QString rrule = QString("FREQ=%1;COUNT=%2").arg(frequencies[frequency]).arg(occurrences);
+    if (recurring) {
+        appendLine(data, QStringLiteral("RRULE:") + rrule);
+    }
+    for(int a = 0; a < attendees; a++) {
+        appendLine(data, QString("ATTENDEE;CN=Attendee %1;PARTSTAT=NEEDS-ACTION:mailto:attendee%1@example.com").arg(a));
+    }
+    for(int a = 0; a < alarms; a++) {
+        appendLine(data, QStringLiteral("BEGIN:VALARM"));
+        appendLine(data, QStringLiteral("ACTION:DISPLAY"));
+        appendLine(data, QStringLiteral("DESCRIPTION:Reminder"));
+        appendLine(data, QString("TRIGGER:-PT%1M").arg((a + 1) * 15));
+        appendLine(data, QStringLiteral("END:VALARM"));
+    }
+    appendLine(data, QStringLiteral("END:VEVENT"));
+
+    statistics->events++;
+    statistics->attendees += attendees;
+    statistics->alarms += alarms;
+    if (!recurring) {
+        return;
+    }
+    statistics->recurringEvents++;
+
+    // detached occurrences, moved one hour later
+    QList<QDateTime> dates = recurrenceDates(rrule, start);
+    for(int o = 1; o < dates.size(); o++) {
+        if (!chance(m_parameters.exceptionDensity)) {
+            continue;
+        }
+        const QDateTime &occurrence = dates[o];
+        appendLine(data, QStringLiteral("BEGIN:VEVENT"));
+        appendLine(data, QStringLiteral("UID:") + uid);
+        appendLine(data, QStringLiteral("DTSTAMP:") + formatDateTime(m_parameters.start));
+        appendLine(data, QStringLiteral("RECURRENCE-ID:") + formatDateTime(occurrence));
+        appendLine(data, QStringLiteral("DTSTART:") + formatDateTime(occurrence.addSecs(60 * 60)));
+        appendLine(data, QStringLiteral("DTEND:") + formatDateTime(occurrence.addSecs(60 * 60 + duration)));
+        appendLine(data, QString("SUMMARY:Workload exception %1.%2.%3").arg(collectionIndex).arg(eventIndex).arg(o));
+        appendLine(data, QStringLiteral("END:VEVENT"));
+        statistics->exceptions++;
+    }
+}
+
+QList<QDateTime> EDSWorkload::recurrenceDates(const QString &rrule, const QDateTime &start)
+{
+    // months without the start day are skipped by the rule, as the backend does
+    icaltimezone *utc = icaltimezone_get_utc_timezone();
+    struct icalrecurrencetype recur = icalrecurrencetype_from_string(rrule.toUtf8().constData());
+    icalrecur_iterator *iterator = icalrecur_iterator_new(recur,
+                                                          icaltime_from_timet_with_zone(start.toTime_t(), 0, utc));
+    QList<QDateTime> dates;
+    for (struct icaltimetype next = icalrecur_iterator_next(iterator);
+         !icaltime_is_null_time(next);
+         next = icalrecur_iterator_next(iterator)) {
+        dates << QDateTime::fromTime_t(icaltime_as_timet_with_zone(next, utc)).toUTC();
+    }
+    icalrecur_iterator_free(iterator);
+    return dates;
+}
+
+void EDSWorkload::appendLine(QByteArray *data, const QString &line)
+{
+    // content lines are folded at 75 octets
+    QByteArray utf8 = line.toUtf8();
+    int offset = 0;
+    int width = 75;
+    while ((utf8.size() - offset) > width) {
+        data->append(utf8.constData() + offset, width);
+        data->append("\r\n ");
+        offset += width;
+        width = 74;
+    }
+    data->append(utf8.constData() + offset, utf8.size() - offset);
+    data->append("\r\n");
+}
+
+QString EDSWorkload::formatDateTime(const QDateTime &dateTime)
+{
+    return dateTime.toUTC().toString(QStringLiteral("yyyyMMdd'T'HHmmss'Z'"));
+}
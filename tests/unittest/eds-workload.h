@@ -0,0 +1,93 @@
+/*
+ * Copyright 2013 Canonical Ltd.
+ *
+ * This file is part of ubuntu-pim-service.
+ *
+ * contact-service-app is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * contact-service-app is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EDS_WORKLOAD__
+#define __EDS_WORKLOAD__
+
+#include <QtCore>
+#include <QtOrganizer>
+
+#include <random>
+
+class QOrganizerEDSEngine;
+
+// Calendars generated from a seed, the same parameters always produce
+// the same iCalendar data
+class EDSWorkload
+{
+public:
+    struct Parameters
+    {
+        Parameters();
+
+        quint32 seed;
+        int collections;
+        int eventsPerCollection;
+        // share of the events with a RRULE
+        double recurringRatio;
+        // chance of each occurrence of a recurring event to be detached
+        double exceptionDensity;
+        int maxOccurrences;
+        int maxAttendees;
+        int maxAlarms;
+        int descriptionSize;
+        QDateTime start;
+        int spanDays;
+    };
+
+    struct Statistics
+    {
+        Statistics();
+
+        int events;
+        int recurringEvents;
+        int exceptions;
+        int attendees;
+        int alarms;
+        qint64 bytes;
+    };
+
+    EDSWorkload(const Parameters &parameters);
+
+    Parameters parameters() const;
+    // sum of the collections generated so far, generating one again replaces its statistics
+    Statistics statistics() const;
+
+    QByteArray calendar(int collectionIndex);
+    QList<QtOrganizer::QOrganizerCollection> populate(QOrganizerEDSEngine *engine,
+                                                       QtOrganizer::QOrganizerManager::Error *error);
+
+private:
+    Parameters m_parameters;
+    // collection index -> statistics of its last generation
+    QMap<int, Statistics> m_statistics;
+    std::mt19937 m_random;
+
+    // std distributions are implementation defined, these are not
+    quint32 next(quint32 bound);
+    bool chance(double probability);
+
+    QString description();
+    void appendEvent(QByteArray *data, Statistics *statistics, int collectionIndex, int eventIndex);
+
+    static QList<QDateTime> recurrenceDates(const QString &rrule, const QDateTime &start);
+    static void appendLine(QByteArray *data, const QString &line);
+    static QString formatDateTime(const QDateTime &dateTime);
+};
+
+#endif
@@ -988,6 +988,339 @@ private Q_SLOTS:
         QVERIFY(vcard.contains("TRIGGER;VALUE=DURATION;RELATED=START:-PT1M"));
     }
 
+    void testUpcomingAlarms()
+    {
+        QDateTime start = QDateTime::fromTime_t(QDateTime::currentDateTime().addSecs(3 * 60 * 60).toTime_t());
+
+        QOrganizerEvent event;
+        QOrganizerItemAudibleReminder aReminder;
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(60 * 60));
+        event.setDisplayLabel(QStringLiteral("upcoming alarm"));
+        aReminder.setSecondsBeforeStart(600);
+        aReminder.setDataUrl(QString());
+        event.saveDetail(&aReminder);
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QList<QOrganizerItem> items;
+        QSignalSpy createdItem(m_engine, SIGNAL(itemsAdded(QList<QOrganizerItemId>)));
+        items << event;
+        bool saveResult = m_engine->saveItems(&items,
+                                              QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                              &errorMap,
+                                              &error);
+        QTRY_COMPARE(createdItem.count(), 1);
+        QVERIFY(saveResult);
+        QOrganizerItemId itemId = items[0].id();
+
+        QDateTime windowStart = start.addSecs(-60 * 60);
+        QDateTime windowEnd = start.addSecs(60 * 60);
+        QList<QPair<QOrganizerItemId, QDateTime> > alarms = m_engine->upcomingAlarms(windowStart, windowEnd);
+        QVERIFY(alarms.contains(qMakePair(itemId, start.addSecs(-600))));
+        for(int i = 1; i < alarms.size(); i++) {
+            QVERIFY(alarms[i - 1].second <= alarms[i].second);
+        }
+
+        // the index must follow item changes
+        QSignalSpy changedItem(m_engine, SIGNAL(itemsChanged(QList<QOrganizerItemId>)));
+        event = items[0];
+        event.setStartDateTime(start.addSecs(30 * 60));
+        event.setEndDateTime(start.addSecs(90 * 60));
+        items.clear();
+        items << event;
+        saveResult = m_engine->saveItems(&items,
+                                         QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                         &errorMap,
+                                         &error);
+        QVERIFY(saveResult);
+        QTRY_VERIFY(changedItem.count() > 0);
+
+        alarms = m_engine->upcomingAlarms(windowStart, windowEnd);
+        QVERIFY(!alarms.contains(qMakePair(itemId, start.addSecs(-600))));
+        QVERIFY(alarms.contains(qMakePair(itemId, start.addSecs(30 * 60 - 600))));
+
+        QSignalSpy removedItem(m_engine, SIGNAL(itemsRemoved(QList<QOrganizerItemId>)));
+        QVERIFY(m_engine->removeItems(QList<QOrganizerItemId>() << itemId, &errorMap, &error));
+        QTRY_VERIFY(removedItem.count() > 0);
+
+        alarms = m_engine->upcomingAlarms(windowStart, windowEnd);
+        QVERIFY(!alarms.contains(qMakePair(itemId, start.addSecs(30 * 60 - 600))));
+    }
+
+    void testUpcomingAlarmsRecurrence()
+    {
+        QDateTime start = QDateTime::fromTime_t(QDateTime::currentDateTime().addSecs(3 * 60 * 60).toTime_t());
+
+        QOrganizerEvent event;
+        QOrganizerItemAudibleReminder aReminder;
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(60 * 60));
+        event.setCollectionId(m_collection.id());
+        event.setDisplayLabel(QStringLiteral("upcoming recurrent alarm"));
+        aReminder.setSecondsBeforeStart(600);
+        aReminder.setDataUrl(QString());
+        event.saveDetail(&aReminder);
+        QOrganizerRecurrenceRule rule;
+        rule.setFrequency(QOrganizerRecurrenceRule::Daily);
+        rule.setLimit(3);
+        event.setRecurrenceRule(rule);
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QList<QOrganizerItem> items;
+        QSignalSpy createdItem(m_engine, SIGNAL(itemsAdded(QList<QOrganizerItemId>)));
+        items << event;
+        QVERIFY(m_engine->saveItems(&items,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+        QTRY_COMPARE(createdItem.count(), 1);
+
+        QDateTime windowStart = start.addSecs(-60 * 60);
+        QDateTime windowEnd = start.addDays(3);
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(m_collection.id());
+        QList<QOrganizerItem> occurrences = m_engine->items(filter, windowStart, windowEnd, -1,
+                                                            QList<QOrganizerItemSortOrder>(),
+                                                            QOrganizerItemFetchHint(), &error);
+        QCOMPARE(occurrences.size(), 3);
+        QList<QPair<QOrganizerItemId, QDateTime> > alarms = m_engine->upcomingAlarms(windowStart, windowEnd);
+        QVERIFY(alarms.contains(qMakePair(occurrences[1].id(), start.addDays(1).addSecs(-600))));
+
+        // the detached occurrence replaces the series alarm
+        QSignalSpy changedItem(m_engine, SIGNAL(itemsChanged(QList<QOrganizerItemId>)));
+        QOrganizerEventOccurrence occurrence = occurrences[1];
+        occurrence.setStartDateTime(start.addDays(1).addSecs(30 * 60));
+        occurrence.setEndDateTime(start.addDays(1).addSecs(90 * 60));
+        items.clear();
+        items << occurrence;
+        QVERIFY(m_engine->saveItems(&items,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+        QTRY_VERIFY(changedItem.count() > 0 || createdItem.count() > 1);
+
+        QTRY_VERIFY(!m_engine->upcomingAlarms(windowStart, windowEnd).contains(
+                        qMakePair(occurrences[1].id(), start.addDays(1).addSecs(-600))));
+        QTRY_VERIFY(m_engine->upcomingAlarms(windowStart, windowEnd).contains(
+                        qMakePair(occurrences[1].id(), start.addDays(1).addSecs(30 * 60 - 600))));
+    }
+
+    void testUpcomingAlarmsOccurrenceMovedOut()
+    {
+        QDateTime start = QDateTime::fromTime_t(QDateTime::currentDateTime().addSecs(3 * 60 * 60).toTime_t());
+
+        QOrganizerEvent event;
+        QOrganizerItemAudibleReminder aReminder;
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(60 * 60));
+        event.setCollectionId(m_collection.id());
+        event.setDisplayLabel(QStringLiteral("upcoming alarm moved out"));
+        aReminder.setSecondsBeforeStart(600);
+        aReminder.setDataUrl(QString());
+        event.saveDetail(&aReminder);
+        QOrganizerRecurrenceRule rule;
+        rule.setFrequency(QOrganizerRecurrenceRule::Daily);
+        rule.setLimit(3);
+        event.setRecurrenceRule(rule);
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QList<QOrganizerItem> items;
+        QSignalSpy createdItem(m_engine, SIGNAL(itemsAdded(QList<QOrganizerItemId>)));
+        items << event;
+        QVERIFY(m_engine->saveItems(&items,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+        QTRY_COMPARE(createdItem.count(), 1);
+
+        QDateTime windowStart = start.addSecs(-60 * 60);
+        QDateTime windowEnd = start.addDays(3);
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(m_collection.id());
+        QList<QOrganizerItem> occurrences = m_engine->items(filter, windowStart, windowEnd, -1,
+                                                            QList<QOrganizerItemSortOrder>(),
+                                                            QOrganizerItemFetchHint(), &error);
+        QCOMPARE(occurrences.size(), 3);
+
+        // move the second occurrence after the window
+        QSignalSpy changedItem(m_engine, SIGNAL(itemsChanged(QList<QOrganizerItemId>)));
+        QOrganizerEventOccurrence occurrence = occurrences[1];
+        occurrence.setStartDateTime(start.addDays(10));
+        occurrence.setEndDateTime(start.addDays(10).addSecs(60 * 60));
+        items.clear();
+        items << occurrence;
+        QVERIFY(m_engine->saveItems(&items,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+        QTRY_VERIFY(changedItem.count() > 0 || createdItem.count() > 1);
+
+        // an earlier window rebuilds the index from the calendar
+        QList<QPair<QOrganizerItemId, QDateTime> > alarms = m_engine->upcomingAlarms(windowStart.addSecs(-60 * 60),
+                                                                                   windowEnd);
+        QVERIFY(alarms.contains(qMakePair(occurrences[0].id(), start.addSecs(-600))));
+        QVERIFY(!alarms.contains(qMakePair(occurrences[1].id(), start.addDays(1).addSecs(-600))));
+        QVERIFY(alarms.contains(qMakePair(occurrences[2].id(), start.addDays(2).addSecs(-600))));
+    }
+
+    void testBusyIntervals()
+    {
+        QDateTime start(QDate(2031, 1, 1), QTime(10, 0, 0));
+
+        QList<QOrganizerItem> items;
+        QOrganizerEvent event;
+        event.setDisplayLabel(QStringLiteral("busy 1"));
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(60 * 60));
+        items << event;
+
+        event = QOrganizerEvent();
+        event.setDisplayLabel(QStringLiteral("busy 2"));
+        event.setStartDateTime(start.addSecs(30 * 60));
+        event.setEndDateTime(start.addSecs(2 * 60 * 60));
+        items << event;
+
+        event = QOrganizerEvent();
+        event.setDisplayLabel(QStringLiteral("busy 3"));
+        event.setStartDateTime(start.addSecs(3 * 60 * 60));
+        event.setEndDateTime(start.addSecs(4 * 60 * 60));
+        items << event;
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QSignalSpy createdItem(m_engine, SIGNAL(itemsAdded(QList<QOrganizerItemId>)));
+        bool saveResult = m_engine->saveItems(&items,
+                                              QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                              &errorMap,
+                                              &error);
+        QTRY_COMPARE(createdItem.count(), 1);
+        QVERIFY(saveResult);
+
+        QList<QOrganizerCollectionId> collections;
+        collections << items[0].collectionId();
+        QList<QPair<QDateTime, QDateTime> > busy = m_engine->busyIntervals(start.addSecs(-60 * 60),
+                                                                           start.addSecs(60 * 60 * 5),
+                                                                           collections,
+                                                                           &error);
+        QCOMPARE(error, QtOrganizer::QOrganizerManager::NoError);
+        QCOMPARE(busy.size(), 2);
+        QCOMPARE(busy[0].first, start);
+        QCOMPARE(busy[0].second, start.addSecs(2 * 60 * 60));
+        QCOMPARE(busy[1].first, start.addSecs(3 * 60 * 60));
+        QCOMPARE(busy[1].second, start.addSecs(4 * 60 * 60));
+
+        // intervals are clipped to the requested range
+        busy = m_engine->busyIntervals(start.addSecs(90 * 60),
+                                       start.addSecs(3 * 60 * 60 + 30 * 60),
+                                       collections,
+                                       &error);
+        QCOMPARE(busy.size(), 2);
+        QCOMPARE(busy[0].first, start.addSecs(90 * 60));
+        QCOMPARE(busy[1].second, start.addSecs(3 * 60 * 60 + 30 * 60));
+    }
+
+    void testBusyIntervalsCancelledEvent()
+    {
+        QByteArray data("BEGIN:VCALENDAR\r\n"
+                        "VERSION:2.0\r\n"
+                        "BEGIN:VEVENT\r\n"
+                        "UID:busy-cancelled\r\n"
+                        "DTSTART:20310201T100000Z\r\n"
+                        "DTEND:20310201T110000Z\r\n"
+                        "STATUS:CANCELLED\r\n"
+                        "SUMMARY:Cancelled meeting\r\n"
+                        "END:VEVENT\r\n"
+                        "END:VCALENDAR\r\n");
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QVERIFY(m_engine->importItems(&buffer, m_collection.id(), &errorMap, &error));
+
+        // cancelled events do not make the calendar busy
+        QDateTime start(QDate(2031, 2, 1), QTime(10, 0, 0), Qt::UTC);
+        QList<QPair<QDateTime, QDateTime> > busy = m_engine->busyIntervals(start.addSecs(-60 * 60),
+                                                                           start.addSecs(2 * 60 * 60),
+                                                                           QList<QOrganizerCollectionId>() << m_collection.id(),
+                                                                           &error);
+        QCOMPARE(error, QtOrganizer::QOrganizerManager::NoError);
+        QVERIFY(busy.isEmpty());
+    }
+
+    void testItemChangesSince()
+    {
+        QList<QOrganizerItemId> added, changed, removed;
+        QString revision;
+        QString currentRevision;
+        QtOrganizer::QOrganizerManager::Error error;
+
+        // the changes are tracked once the collection view listed its items
+        QTRY_VERIFY(m_engine->itemChangesSince(m_collection.id(), revision,
+                                               &added, &changed, &removed,
+                                               &revision, &error));
+        QVERIFY(!revision.isEmpty());
+
+        QOrganizerTodo todo;
+        todo.setCollectionId(m_collection.id());
+        todo.setDisplayLabel(QStringLiteral("delta sync"));
+        QList<QOrganizerItem> items;
+        items << todo;
+
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QSignalSpy createdItem(m_engine, SIGNAL(itemsAdded(QList<QOrganizerItemId>)));
+        QVERIFY(m_engine->saveItems(&items, QList<QOrganizerItemDetail::DetailType>(), &errorMap, &error));
+        QTRY_COMPARE(createdItem.count(), 1);
+        QOrganizerItemId itemId = items[0].id();
+
+        QTRY_VERIFY(m_engine->itemChangesSince(m_collection.id(), revision,
+                                               &added, &changed, &removed,
+                                               &currentRevision, &error) &&
+                    (currentRevision != revision));
+        QCOMPARE(added, QList<QOrganizerItemId>() << itemId);
+        QVERIFY(changed.isEmpty());
+        QVERIFY(removed.isEmpty());
+        revision = currentRevision;
+
+        // modified after the last revision
+        QSignalSpy changedItem(m_engine, SIGNAL(itemsChanged(QList<QOrganizerItemId>)));
+        items[0].setDisplayLabel(QStringLiteral("delta sync changed"));
+        QVERIFY(m_engine->saveItems(&items, QList<QOrganizerItemDetail::DetailType>(), &errorMap, &error));
+        QTRY_COMPARE(changedItem.count(), 1);
+        QTRY_VERIFY(m_engine->itemChangesSince(m_collection.id(), revision,
+                                               &added, &changed, &removed,
+                                               &currentRevision, &error) &&
+                    (currentRevision != revision));
+        // the journal may report again the changes of the last revision
+        QVERIFY(changed.contains(itemId) || added.contains(itemId));
+        QVERIFY(removed.isEmpty());
+        revision = currentRevision;
+
+        QSignalSpy removedItem(m_engine, SIGNAL(itemsRemoved(QList<QOrganizerItemId>)));
+        QVERIFY(m_engine->removeItems(QList<QOrganizerItemId>() << itemId, &errorMap, &error));
+        QTRY_COMPARE(removedItem.count(), 1);
+        QTRY_VERIFY(m_engine->itemChangesSince(m_collection.id(), revision,
+                                               &added, &changed, &removed,
+                                               &currentRevision, &error) &&
+                    (currentRevision != revision));
+        QCOMPARE(removed, QList<QOrganizerItemId>() << itemId);
+
+        // unknown revisions need a full fetch
+        QVERIFY(!m_engine->itemChangesSince(m_collection.id(), QStringLiteral("unknown"),
+                                            &added, &changed, &removed,
+                                            &currentRevision, &error));
+        QCOMPARE(error, QOrganizerManager::DoesNotExistError);
+        QVERIFY(!currentRevision.isEmpty());
+
+        QVERIFY(!m_engine->itemChangesSince(QOrganizerCollectionId(), revision,
+                                            &added, &changed, &removed,
+                                            &currentRevision, &error));
+        QCOMPARE(error, QOrganizerManager::InvalidCollectionError);
+    }
+
     // BUG: #1445577
     void testUTCEvent()
     {
@@ -25,7 +25,9 @@
 
 #include "qorganizer-eds-engine.h"
 #include "qorganizer-eds-requestdata.h"
+#include "qorganizer-eds-metrics.h"
 #include "eds-base-test.h"
+#include "eds-workload.h"
 
 
 using namespace QtOrganizer;
@@ -171,6 +173,155 @@ private Q_SLOTS:
         QList<QOrganizerItem> result = m_engine->items(filter, QDateTime(), QDateTime(), 100, sort, hint, &error);
         QCOMPARE(result.size(), 10);
     }
+
+    void testFetchSummaryWithoutDate()
+    {
+        QOrganizerItemFilter filter;
+        QOrganizerItemFetchHint hint;
+        QOrganizerManager::Error error;
+        QList<QOrganizerItemSortOrder> sort;
+
+        // only label and time, description should not be fetched
+        hint.setDetailTypesHint(QList<QOrganizerItemDetail::DetailType>()
+                                << QOrganizerItemDetail::TypeDisplayLabel
+                                << QOrganizerItemDetail::TypeEventTime);
+
+        QList<QOrganizerItem> result = m_engine->items(filter, QDateTime(), QDateTime(), 100, sort, hint, &error);
+        QCOMPARE(result.size(), 10);
+        Q_FOREACH(const QOrganizerItem &item, result) {
+            QOrganizerEvent ev(item);
+            QVERIFY(!ev.id().isNull());
+            QVERIFY(ev.displayLabel().startsWith(QStringLiteral("Display Label")));
+            QVERIFY(ev.startDateTime().isValid());
+            QVERIFY(ev.endDateTime().isValid());
+            QVERIFY(ev.description().isEmpty());
+        }
+    }
+
+    void testFetchWithDateFromCollections()
+    {
+        // the second collection is parsed while the first one is fetched
+        QOrganizerCollection collection;
+        QtOrganizer::QOrganizerManager::Error error;
+        collection.setMetaData(QOrganizerCollection::KeyName, uniqueCollectionName());
+        QVERIFY(m_engine->saveCollection(&collection, &error));
+
+        QList<QOrganizerItem> evs;
+        for(int i=0; i<2; i++) {
+            QOrganizerEvent ev;
+            ev.setCollectionId(collection.id());
+            ev.setStartDateTime(QOrganizerEvent(m_events[i]).startDateTime().addSecs(60));
+            ev.setEndDateTime(ev.startDateTime().addSecs(60*30));
+            ev.setDisplayLabel(QString("Second collection %1").arg(i));
+            evs << ev;
+        }
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QVERIFY(m_engine->saveItems(&evs,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionIds(QSet<QOrganizerCollectionId>() << m_collection.id() << collection.id());
+        QOrganizerItemSortOrder sort;
+        sort.setDetail(QOrganizerItemDetail::TypeEventTime, QOrganizerEventTime::FieldStartDateTime);
+        QOrganizerItemFetchHint hint;
+
+        QDateTime start = QOrganizerEvent(m_events.first()).startDateTime().addSecs(-60);
+        QDateTime end = QOrganizerEvent(m_events.last()).endDateTime().addSecs(60);
+        QList<QOrganizerItem> result = m_engine->items(filter, start, end, 100,
+                                                       QList<QOrganizerItemSortOrder>() << sort,
+                                                       hint, &error);
+        QCOMPARE(error, QOrganizerManager::NoError);
+        QCOMPARE(result.size(), 12);
+        QCOMPARE(result[0].displayLabel(), m_events[0].displayLabel());
+        QCOMPARE(result[1].displayLabel(), QStringLiteral("Second collection 0"));
+        QCOMPARE(result[2].displayLabel(), m_events[1].displayLabel());
+        QCOMPARE(result[3].displayLabel(), QStringLiteral("Second collection 1"));
+
+        QVERIFY(m_engine->removeCollection(collection.id(), &error));
+    }
+
+    void testFetchRequestStats()
+    {
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(m_collection.id());
+        QOrganizerManager::Error error;
+        QDateTime start = QOrganizerEvent(m_events.first()).startDateTime().addSecs(-60);
+        QDateTime end = QOrganizerEvent(m_events.last()).endDateTime().addSecs(60);
+        QList<QOrganizerItem> result = m_engine->items(filter, start, end, 100,
+                                                       QList<QOrganizerItemSortOrder>(),
+                                                       QOrganizerItemFetchHint(), &error);
+        QCOMPARE(result.size(), 10);
+
+        QList<RequestStats> stats = m_engine->requestStats();
+        QVERIFY(!stats.isEmpty());
+        RequestStats last = stats.last();
+        QCOMPARE(last.type, QOrganizerAbstractRequest::ItemFetchRequest);
+        QCOMPARE(last.state, QOrganizerAbstractRequest::FinishedState);
+        QCOMPARE(last.error, QOrganizerManager::NoError);
+        QCOMPARE(last.items, 10);
+        QVERIFY(last.phases[RequestStats::DBusCall] > 0);
+        for(int i = 0; i < RequestStats::PhaseCount; i++) {
+            QVERIFY(last.phases[i] >= 0);
+            QVERIFY(last.phases[i] <= last.total);
+        }
+    }
+
+    void testFetchMetrics()
+    {
+        EngineMetrics::instance()->clear();
+
+        QOrganizerItemFilter filter;
+        QOrganizerManager::Error error;
+        QList<QOrganizerItem> result = m_engine->items(filter, QDateTime(), QDateTime(), 100,
+                                                       QList<QOrganizerItemSortOrder>(),
+                                                       QOrganizerItemFetchHint(), &error);
+        QCOMPARE(result.size(), 10);
+
+        QCOMPARE(EngineMetrics::instance()->requestLatency(QOrganizerAbstractRequest::ItemFetchRequest).count(), 1);
+        QVERIFY(EngineMetrics::instance()->parsedItems() >= 10);
+
+        QMap<QString, QString> metrics = m_engine->metrics();
+        QVERIFY(metrics.value("latency-fetch").startsWith(QStringLiteral("count=1 ")));
+        QVERIFY(metrics.contains("parse-throughput"));
+        QVERIFY(metrics.contains("recurrence-cache-hit-ratio"));
+        QCOMPARE(metrics.value("running-requests"), QStringLiteral("0"));
+        QCOMPARE(metrics.value("pending-requests"), QStringLiteral("0"));
+    }
+
+    void testFetchWorkload()
+    {
+        EDSWorkload::Parameters parameters;
+        parameters.seed = 7;
+        parameters.eventsPerCollection = 30;
+        parameters.recurringRatio = 0.3;
+        parameters.exceptionDensity = 0.2;
+        EDSWorkload workload(parameters);
+
+        QOrganizerManager::Error error;
+        QList<QOrganizerCollection> collections = workload.populate(m_engine, &error);
+        QCOMPARE(error, QOrganizerManager::NoError);
+        QCOMPARE(collections.size(), 1);
+
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(collections[0].id());
+        QList<QOrganizerItem> items = m_engine->items(filter,
+                                                      QDateTime(),
+                                                      QDateTime(),
+                                                      -1,
+                                                      QList<QOrganizerItemSortOrder>(),
+                                                      QOrganizerItemFetchHint(),
+                                                      &error);
+        QCOMPARE(error, QOrganizerManager::NoError);
+
+        // detached occurrences share the uid of their series
+        QSet<QString> uids;
+        Q_FOREACH(const QOrganizerItem &item, items) {
+            uids << item.guid();
+        }
+        QCOMPARE(uids.size(), workload.statistics().events);
+    }
 };
 
 QTEST_MAIN(FetchItemTest)
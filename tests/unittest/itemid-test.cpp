@@ -66,6 +66,52 @@ private Q_SLOTS:
         QString targetId = QString("qtorganizer:eds::") + id.toString();
         QCOMPARE(id2.toString(), targetId);
     }
+
+    void testParseIdString()
+    {
+        QOrganizerEDSEngineId id(QStringLiteral("qtorganizer:eds::system-calendar/20130814T212003Z-13580-1000-1995-22@ubuntu#100200023"));
+        QCOMPARE(id.collectionId(), QStringLiteral("system-calendar"));
+        QCOMPARE(id.uid(), QStringLiteral("20130814T212003Z-13580-1000-1995-22@ubuntu"));
+        QCOMPARE(id.rid(), QStringLiteral("100200023"));
+        QCOMPARE(id.toString(),
+                 QStringLiteral("system-calendar/20130814T212003Z-13580-1000-1995-22@ubuntu#100200023"));
+
+        QOrganizerEDSEngineId id2(QStringLiteral("system-calendar"),
+                                  QStringLiteral("20130814T212003Z-13580-1000-1995-22@ubuntu"),
+                                  QStringLiteral("100200023"));
+        QVERIFY(id.isEqualTo(&id2));
+        QCOMPARE(id.hash(), id2.hash());
+        QCOMPARE(id.hash(), qHash(QStringLiteral("20130814T212003Z-13580-1000-1995-22@ubuntu#100200023")));
+        // interned values are shared between ids
+        QVERIFY(id.uid().constData() == id2.uid().constData());
+        QVERIFY(id.collectionId().constData() == id2.collectionId().constData());
+
+        QOrganizerEDSEngineId parentId(QStringLiteral("system-calendar"),
+                                       QStringLiteral("20130814T212003Z-13580-1000-1995-22@ubuntu"));
+        QVERIFY(!parentId.isEqualTo(&id));
+        QVERIFY(parentId.isLessThan(&id));
+        QVERIFY(parentId.rid().isEmpty());
+    }
+
+    void testSplitItemId()
+    {
+        QString collectionId;
+        QString uid;
+        QString rid;
+        QVERIFY(QOrganizerEDSEngineId::splitItemId(QStringLiteral("qtorganizer:eds::system-calendar/20130814T212003Z-13580-1000-1995-22@ubuntu#100200023"),
+                                                   &collectionId, &uid, &rid));
+        QCOMPARE(collectionId, QStringLiteral("qtorganizer:eds::system-calendar"));
+        QCOMPARE(uid, QStringLiteral("20130814T212003Z-13580-1000-1995-22@ubuntu"));
+        QCOMPARE(rid, QStringLiteral("100200023"));
+
+        collectionId.clear();
+        QVERIFY(QOrganizerEDSEngineId::splitItemId(QStringLiteral("qtorganizer:eds::system-calendar/20130814T212003Z-13580-1000-1995-22@ubuntu"),
+                                                   &collectionId));
+        QCOMPARE(collectionId, QStringLiteral("qtorganizer:eds::system-calendar"));
+
+        QVERIFY(!QOrganizerEDSEngineId::splitItemId(QStringLiteral("qtorganizer:eds::system-calendar"),
+                                                    &collectionId));
+    }
 };
 
 QTEST_MAIN(ItemIdTest)
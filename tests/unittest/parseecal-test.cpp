@@ -19,9 +19,20 @@
 //ugly hack but this allow us to test the engine without mock EDS
 #define private public
 #include "qorganizer-eds-engine.h"
+#include "qorganizer-eds-calendarimporter.h"
 #undef private
 
+#include "qorganizer-eds-timezonecache.h"
+#include "qorganizer-eds-stringpool.h"
+#include "qorganizer-eds-recurrencecache.h"
+#include "qorganizer-eds-freebusy.h"
+#include "qorganizer-eds-changejournal.h"
+#include "qorganizer-eds-requeststats.h"
+#include "qorganizer-eds-metrics.h"
+#include "qorganizer-eds-engineid.h"
+#include "qorganizer-eds-collection-engineid.h"
 #include "gscopedpointer.h"
+#include "eds-workload.h"
 
 #include <QObject>
 #include <QtTest>
@@ -377,6 +388,412 @@ private Q_SLOTS:
         g_object_unref(comp);
     }
 
+    void testTimeZoneCache()
+    {
+        TimeZoneCache *cache = TimeZoneCache::instance();
+        cache->clear();
+
+        const char *tzId = "/freeassociation.sourceforge.net/Tzfile/America/Recife";
+        struct icaltimetype itt = icaltime_from_string("20150408T190000");
+        QDateTime expected(QDate(2015, 4, 8), QTime(19, 0, 0), QTimeZone("America/Recife"));
+
+        QCOMPARE(QOrganizerEDSEngine::fromIcalTime(itt, tzId), expected);
+        QCOMPARE(cache->misses(), 1);
+        QCOMPARE(cache->hits(), 0);
+
+        // second conversion must be served by the cache
+        QCOMPARE(QOrganizerEDSEngine::fromIcalTime(itt, tzId), expected);
+        QCOMPARE(cache->misses(), 1);
+        QCOMPARE(cache->hits(), 1);
+
+        // location names are accepted as tzid
+        QCOMPARE(QOrganizerEDSEngine::fromIcalTime(itt, "America/Recife"), expected);
+        QCOMPARE(cache->misses(), 2);
+
+        // convert back using the cached builtin timezone
+        QByteArray outTzId;
+        struct icaltimetype back = QOrganizerEDSEngine::fromQDateTime(expected, false, &outTzId);
+        QCOMPARE(back.year, 2015);
+        QCOMPARE(back.month, 4);
+        QCOMPARE(back.day, 8);
+        QCOMPARE(back.hour, 19);
+        QVERIFY(outTzId.endsWith("America/Recife"));
+    }
+
+    void testStringPool()
+    {
+        StringPool *pool = StringPool::instance();
+        pool->clear();
+
+        QList<QOrganizerItem> items;
+        for (int i = 0; i < 2; i++) {
+            ECalComponent *comp = e_cal_component_new();
+            e_cal_component_set_new_vtype(comp, E_CAL_COMPONENT_EVENT);
+            e_cal_component_set_location(comp, "Conference room");
+            GSList *categories = g_slist_append(0, (gpointer) "Work");
+            e_cal_component_set_categories_list(comp, categories);
+            g_slist_free(categories);
+
+            QOrganizerEvent item;
+            QOrganizerEDSEngine::parseLocation(comp, &item);
+            QOrganizerEDSEngine::parseTags(comp, &item);
+            items << item;
+            g_object_unref(comp);
+        }
+
+        QOrganizerEvent first = items[0];
+        QOrganizerEvent second = items[1];
+        QCOMPARE(first.location(), QStringLiteral("Conference room"));
+        QCOMPARE(second.tags(), QStringList() << QStringLiteral("Work"));
+
+        // both items point to the same string data
+        QVERIFY(first.location().constData() == second.location().constData());
+        QVERIFY(first.tags().first().constData() == second.tags().first().constData());
+        QCOMPARE(pool->hits(), 2);
+        QCOMPARE(pool->savedBytes(), qint64((15 + 4) * sizeof(QChar)));
+
+        // strings only referenced by the pool are released
+        items.clear();
+        first = QOrganizerEvent();
+        second = QOrganizerEvent();
+        int size = pool->size();
+        pool->prune();
+        QCOMPARE(pool->size(), size - 2);
+
+        // lookups by reference or from utf8 return the pooled string
+        QString value = pool->intern(QString::fromLatin1("Pooled value"));
+        QString prefixed = QString::fromLatin1("prefix:Pooled value");
+        QVERIFY(pool->intern(prefixed.midRef(7)).constData() == value.constData());
+        QVERIFY(pool->intern("Pooled value").constData() == value.constData());
+        QCOMPARE(pool->hits(), 4);
+    }
+
+    void testRecurrenceCache()
+    {
+        RecurrenceCache *cache = RecurrenceCache::instance();
+        cache->clear();
+
+        icalcomponent *ical = icalcomponent_new_from_string(vEvent.toUtf8().data());
+        QVERIFY(ical);
+        ECalComponent *comp = e_cal_component_new_from_icalcomponent(ical);
+
+        QOrganizerEvent first;
+        QOrganizerEDSEngine::parseRecurrence(comp, &first);
+        QCOMPARE(cache->misses(), 1);
+        QCOMPARE(cache->hits(), 0);
+
+        // other occurrences of the same series reuse the converted rules
+        QOrganizerEvent second;
+        QOrganizerEDSEngine::parseRecurrence(comp, &second);
+        QCOMPARE(cache->misses(), 1);
+        QCOMPARE(cache->hits(), 1);
+        QCOMPARE(second.recurrenceRule().frequency(), QOrganizerRecurrenceRule::Daily);
+        QCOMPARE(second.exceptionDates(), first.exceptionDates());
+        QCOMPARE(second.exceptionDates().size(), 2);
+
+        // a new version of the series must be converted again
+        gint sequence = 7;
+        e_cal_component_set_sequence(comp, &sequence);
+        e_cal_component_set_exdate_list(comp, 0);
+        QOrganizerEvent third;
+        QOrganizerEDSEngine::parseRecurrence(comp, &third);
+        QCOMPARE(cache->misses(), 2);
+        QVERIFY(third.exceptionDates().isEmpty());
+
+        cache->remove(QOrganizerCollectionId().toString(), QStringLiteral("20150408T215243Z-19265-1000-5926-24@renato-ubuntu"));
+        QOrganizerEvent fourth;
+        QOrganizerEDSEngine::parseRecurrence(comp, &fourth);
+        QCOMPARE(cache->misses(), 3);
+
+        // the same series in another collection is not shared
+        QOrganizerItemRecurrence recurrence;
+        QVERIFY(cache->find(QOrganizerCollectionId().toString(), ical, &recurrence));
+        QVERIFY(!cache->find(QStringLiteral("qtorganizer:eds::other-collection"), ical, &recurrence));
+
+        g_object_unref(comp);
+    }
+
+    void testParseSeriesOccurrences()
+    {
+        GSList *events = 0;
+        QList<QDateTime> starts;
+        for (int i = 0; i < 3; i++) {
+            icalcomponent *ical = icalcomponent_new_from_string(vEvent.toUtf8().data());
+            QVERIFY(ical);
+            icaltimezone *tz = icaltimezone_get_builtin_timezone("America/Recife");
+            struct icaltimetype start = icaltime_from_string("20150410T190000");
+            icaltime_adjust(&start, i, 0, 0, 0);
+            start = icaltime_set_timezone(&start, tz);
+            struct icaltimetype end = start;
+            icaltime_adjust(&end, 0, 0, 30, 0);
+            icalcomponent_set_dtstart(ical, start);
+            icalcomponent_set_dtend(ical, end);
+            icalcomponent_set_recurrenceid(ical, start);
+            events = g_slist_append(events, ical);
+            starts << QDateTime(QDate(2015, 4, 10 + i), QTime(19, 0, 0), QTimeZone("America/Recife"));
+        }
+
+        QOrganizerEDSCollectionEngineId collectionId(QStringLiteral("system-calendar"));
+        QList<QOrganizerItem> items = QOrganizerEDSEngine::parseEvents(&collectionId, events, true, QList<QOrganizerItemDetail::DetailType>());
+        g_slist_free_full(events, (GDestroyNotify) icalcomponent_free);
+
+        QCOMPARE(items.size(), 3);
+        QSet<QOrganizerItemId> ids;
+        for (int i = 0; i < items.size(); i++) {
+            QOrganizerEventOccurrence occurrence = items[i];
+            QCOMPARE(occurrence.type(), QOrganizerItemType::TypeEventOccurrence);
+            // occurrence specific details
+            QCOMPARE(occurrence.startDateTime(), starts[i]);
+            QCOMPARE(occurrence.endDateTime(), starts[i].addSecs(30 * 60));
+            ids << occurrence.id();
+            // series details
+            QCOMPARE(occurrence.displayLabel(), QStringLiteral("one minute after start"));
+            QCOMPARE(occurrence.description(), QStringLiteral("event to parse"));
+            QCOMPARE(occurrence.details(QOrganizerItemDetail::TypeVisualReminder).size(), 1);
+        }
+        QCOMPARE(ids.size(), 3);
+    }
+
+    void testMergeBusyIntervals()
+    {
+        QList<FreeBusy::Interval> intervals;
+        QVERIFY(FreeBusy::mergeIntervals(intervals).isEmpty());
+
+        // unsorted, overlapping, contained and touching intervals
+        intervals << qMakePair(time_t(50), time_t(60))
+                  << qMakePair(time_t(10), time_t(20))
+                  << qMakePair(time_t(15), time_t(30))
+                  << qMakePair(time_t(16), time_t(18))
+                  << qMakePair(time_t(30), time_t(40))
+                  << qMakePair(time_t(70), time_t(80))
+                  << qMakePair(time_t(55), time_t(56));
+
+        QList<FreeBusy::Interval> merged = FreeBusy::mergeIntervals(intervals);
+        QCOMPARE(merged.size(), 3);
+        QCOMPARE(merged[0], qMakePair(time_t(10), time_t(40)));
+        QCOMPARE(merged[1], qMakePair(time_t(50), time_t(60)));
+        QCOMPARE(merged[2], qMakePair(time_t(70), time_t(80)));
+    }
+
+    void testChangeJournal()
+    {
+        ChangeJournal journal;
+        QList<QOrganizerItemId> added, changed, removed;
+        QOrganizerItemId first(new QOrganizerEDSEngineId("collection", "first"));
+        QOrganizerItemId second(new QOrganizerEDSEngineId("collection", "second"));
+        QOrganizerItemId third(new QOrganizerEDSEngineId("collection", "third"));
+
+        // changes are only kept after the collection was listed
+        journal.record("collection", "r1", QOrganizerManager::Add, QList<QOrganizerItemId>() << first);
+        QVERIFY(!journal.changesSince("collection", "r1", "r1", &added, &changed, &removed));
+
+        journal.reset("collection", "r1");
+        journal.record("collection", "r1", QOrganizerManager::Add, QList<QOrganizerItemId>() << first);
+        journal.record("collection", "r2", QOrganizerManager::Change, QList<QOrganizerItemId>() << first << second);
+        journal.record("collection", "r3", QOrganizerManager::Remove, QList<QOrganizerItemId>() << second);
+        journal.record("collection", "r3", QOrganizerManager::Add, QList<QOrganizerItemId>() << third);
+
+        QVERIFY(journal.changesSince("collection", "r1", "r3", &added, &changed, &removed));
+        QCOMPARE(added, QList<QOrganizerItemId>() << first << third);
+        QVERIFY(changed.isEmpty());
+        QCOMPARE(removed, QList<QOrganizerItemId>() << second);
+
+        added.clear();
+        QVERIFY(journal.changesSince("collection", "r2", "r3", &added, &changed, &removed));
+        QCOMPARE(added, QList<QOrganizerItemId>() << third);
+        QCOMPARE(changed, QList<QOrganizerItemId>() << first);
+
+        // nothing new for the current revision
+        added.clear();
+        changed.clear();
+        removed.clear();
+        QVERIFY(journal.changesSince("collection", "r4", "r4", &added, &changed, &removed));
+        QVERIFY(added.isEmpty() && changed.isEmpty() && removed.isEmpty());
+
+        // unknown revisions and collections need a full fetch
+        QVERIFY(!journal.changesSince("collection", "r0", "r4", &added, &changed, &removed));
+        QVERIFY(!journal.changesSince("collection", QString(), "r4", &added, &changed, &removed));
+        journal.removeCollection("collection");
+        QVERIFY(!journal.changesSince("collection", "r4", "r4", &added, &changed, &removed));
+    }
+
+    void testRequestStatsLog()
+    {
+        RequestStatsLog log(3);
+        QVERIFY(log.stats().isEmpty());
+
+        // the oldest stats are dropped once the log is full
+        for(int i = 0; i < 5; i++) {
+            RequestStats stats;
+            stats.items = i;
+            log.append(stats);
+        }
+        QList<RequestStats> stats = log.stats();
+        QCOMPARE(stats.size(), 3);
+        QCOMPARE(stats[0].items, 2);
+        QCOMPARE(stats[1].items, 3);
+        QCOMPARE(stats[2].items, 4);
+        QVERIFY(stats[2].toString().contains(QStringLiteral("dbus=0")));
+    }
+
+    void testMetricsHistogram()
+    {
+        QCOMPARE(MetricsHistogram::bucketIndex(0), 0);
+        QCOMPARE(MetricsHistogram::bucketIndex(1), 1);
+        QCOMPARE(MetricsHistogram::bucketIndex(3), 2);
+        QCOMPARE(MetricsHistogram::bucketIndex(4), 3);
+        QCOMPARE(MetricsHistogram::bucketIndex(Q_INT64_C(1) << 40), int(MetricsHistogram::BucketCount) - 1);
+
+        MetricsHistogram histogram;
+        QCOMPARE(histogram.percentile(50), qint64(0));
+        for(int i = 0; i < 90; i++) {
+            histogram.add(100);
+        }
+        for(int i = 0; i < 10; i++) {
+            histogram.add(5000);
+        }
+        QCOMPARE(histogram.count(), 100);
+        QCOMPARE(histogram.bucket(MetricsHistogram::bucketIndex(100)), 90);
+        QCOMPARE(histogram.percentile(50), qint64(128));
+        QCOMPARE(histogram.percentile(90), qint64(128));
+        QCOMPARE(histogram.percentile(99), qint64(8192));
+
+        histogram.clear();
+        QCOMPARE(histogram.count(), 0);
+    }
+
+    void testWorkloadIsDeterministic()
+    {
+        EDSWorkload::Parameters parameters;
+        parameters.seed = 42;
+        parameters.collections = 2;
+        parameters.eventsPerCollection = 50;
+        parameters.recurringRatio = 0.5;
+        parameters.exceptionDensity = 0.3;
+        parameters.descriptionSize = 300;
+
+        EDSWorkload first(parameters);
+        EDSWorkload second(parameters);
+        QByteArray data = first.calendar(0);
+        QCOMPARE(second.calendar(0), data);
+        QVERIFY(first.calendar(1) != data);
+
+        parameters.seed = 43;
+        EDSWorkload other(parameters);
+        QVERIFY(other.calendar(0) != data);
+
+        // folded lines and a valid calendar
+        Q_FOREACH(const QByteArray &line, data.split('\n')) {
+            QVERIFY(line.size() <= 76);
+        }
+        icalcomponent *ical = icalparser_parse_string(data.constData());
+        QVERIFY(ical);
+        EDSWorkload::Statistics statistics = second.statistics();
+        QCOMPARE(statistics.events, 50);
+        QVERIFY(statistics.recurringEvents > 0);
+        QVERIFY(statistics.exceptions > 0);
+        QCOMPARE(icalcomponent_count_components(ical, ICAL_VEVENT_COMPONENT),
+                 statistics.events + statistics.exceptions);
+        QCOMPARE(statistics.bytes, qint64(data.size()));
+        icalcomponent_free(ical);
+
+        // generating a collection again does not count it twice
+        second.calendar(0);
+        QCOMPARE(second.statistics().events, 50);
+        QCOMPARE(second.statistics().bytes, qint64(data.size()));
+    }
+
+    void testWorkloadExceptionsMatchOccurrences()
+    {
+        // monthly series starting on days 29-31 skip the shorter months
+        EDSWorkload::Parameters parameters;
+        parameters.seed = 7;
+        parameters.eventsPerCollection = 300;
+        parameters.recurringRatio = 1.0;
+        parameters.exceptionDensity = 0.5;
+        parameters.maxOccurrences = 12;
+        EDSWorkload workload(parameters);
+
+        icalcomponent *ical = icalparser_parse_string(workload.calendar(0).constData());
+        QVERIFY(ical);
+        QHash<QString, icalcomponent*> masters;
+        for (icalcomponent *comp = icalcomponent_get_first_component(ical, ICAL_VEVENT_COMPONENT);
+             comp; comp = icalcomponent_get_next_component(ical, ICAL_VEVENT_COMPONENT)) {
+            if (!icalcomponent_get_first_property(comp, ICAL_RECURRENCEID_PROPERTY)) {
+                masters.insert(QString::fromUtf8(icalcomponent_get_uid(comp)), comp);
+            }
+        }
+
+        int exceptions = 0;
+        for (icalcomponent *comp = icalcomponent_get_first_component(ical, ICAL_VEVENT_COMPONENT);
+             comp; comp = icalcomponent_get_next_component(ical, ICAL_VEVENT_COMPONENT)) {
+            if (!icalcomponent_get_first_property(comp, ICAL_RECURRENCEID_PROPERTY)) {
+                continue;
+            }
+            icalcomponent *master = masters.value(QString::fromUtf8(icalcomponent_get_uid(comp)));
+            QVERIFY(master);
+            icalproperty *rrule = icalcomponent_get_first_property(master, ICAL_RRULE_PROPERTY);
+            QVERIFY(rrule);
+
+            struct icaltimetype rid = icalcomponent_get_recurrenceid(comp);
+            icalrecur_iterator *iterator = icalrecur_iterator_new(icalproperty_get_rrule(rrule),
+                                                                  icalcomponent_get_dtstart(master));
+            bool found = false;
+            for (struct icaltimetype next = icalrecur_iterator_next(iterator);
+                 !icaltime_is_null_time(next) && !found;
+                 next = icalrecur_iterator_next(iterator)) {
+                found = (icaltime_compare(next, rid) == 0);
+            }
+            icalrecur_iterator_free(iterator);
+            QVERIFY2(found, icaltime_as_ical_string(rid));
+            exceptions++;
+        }
+        QCOMPARE(exceptions, workload.statistics().exceptions);
+        icalcomponent_free(ical);
+    }
+
+    void testImportReadComponents()
+    {
+        QByteArray data("BEGIN:VCALENDAR\r\n"
+                        "VERSION:2.0\r\n"
+                        "BEGIN:VEVENT\r\n"
+                        "UID:event-1\r\n"
+                        "SUMMARY:first\r\n"
+                        "BEGIN:VALARM\r\n"
+                        "ACTION:DISPLAY\r\n"
+                        "END:VALARM\r\n"
+                        "END:VEVENT\r\n"
+                        "BEGIN:VEVENT\r\n"
+                        "UID:event-2\r\n"
+                        "DESCRIPTION:folded\r\n"
+                        " BEGIN:VEVENT\r\n"
+                        "END:VEVENT\r\n"
+                        "END:VCALENDAR\r\n"
+                        "BEGIN:VCALENDAR\r\n"
+                        "BEGIN:VTODO\r\n"
+                        "UID:todo-1\r\n"
+                        "END:VTODO\r\n"
+                        "END:VCALENDAR\r\n");
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        CalendarImporter importer(0, &buffer);
+        QByteArray component = importer.readComponent();
+        QVERIFY(component.startsWith("BEGIN:VEVENT\r\nUID:event-1"));
+        QVERIFY(component.contains("END:VALARM"));
+        QVERIFY(component.endsWith("END:VEVENT\r\n"));
+
+        component = importer.readComponent();
+        QVERIFY(component.startsWith("BEGIN:VEVENT\r\nUID:event-2"));
+        QVERIFY(component.endsWith(" BEGIN:VEVENT\r\nEND:VEVENT\r\n"));
+
+        // components of following calendars in the same stream
+        component = importer.readComponent();
+        QCOMPARE(component, QByteArray("BEGIN:VTODO\r\nUID:todo-1\r\nEND:VTODO\r\n"));
+
+        QVERIFY(importer.readComponent().isEmpty());
+    }
+
     void testAsyncParse()
     {
         qRegisterMetaType<QList<QOrganizerItem> >();
@@ -387,9 +804,10 @@ private Q_SLOTS:
         QVERIFY(icalcomponent_is_valid(ical));
 
         QList<QOrganizerItemDetail::DetailType> detailsHint;
-        GSList *events = g_slist_append(events, ical);
+        GSList *events = g_slist_append(0, ical);
         QMap<QString, GSList*> eventMap;
         eventMap.insert(engine->defaultCollection(0).id().toString(), events);
+        // the parse thread takes the ownership of the components
         engine->parseEventsAsync(eventMap, true, detailsHint, this, SLOT(onEventAsyncParsed(QList<QOrganizerItem>)));
 
         QTRY_COMPARE(m_itemsParsed.size(), 1);
@@ -414,8 +832,6 @@ private Q_SLOTS:
         QCOMPARE(vreminder.secondsBeforeStart(), 60);
         QCOMPARE(vreminder.message(), QStringLiteral("alarm to parse"));
 
-        g_slist_free_full(events, (GDestroyNotify)icalcomponent_free);
-        icalcomponent_free(ical);
         delete engine;
     }
 };
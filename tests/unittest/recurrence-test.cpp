@@ -24,6 +24,7 @@
 #include <QtOrganizer>
 
 #include "qorganizer-eds-engine.h"
+#include "qorganizer-eds-fetchrequestdata.h"
 #include "eds-base-test.h"
 
 
@@ -74,6 +75,33 @@ private:
         return items[0];
     }
 
+    QList<QOrganizerItem> fetchOccurrences(const QDateTime &start,
+                                           const QDateTime &end,
+                                           bool localExpansion)
+    {
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(m_collection.id());
+
+        QOrganizerItemFetchRequest req(m_engine);
+        req.setFilter(filter);
+        req.setStartDate(start);
+        req.setEndDate(end);
+        req.setProperty(LOCAL_EXPANSION_PROPERTY, localExpansion);
+
+        m_engine->startRequest(&req);
+        m_engine->waitForRequestFinished(&req, 0);
+        Q_ASSERT(req.error() == QtOrganizer::QOrganizerManager::NoError);
+
+        QList<QOrganizerItem> items = req.items();
+        qSort(items.begin(), items.end(), startDateLessThan);
+        return items;
+    }
+
+    static bool startDateLessThan(const QOrganizerItem &a, const QOrganizerItem &b)
+    {
+        return QOrganizerEventOccurrence(a).startDateTime() < QOrganizerEventOccurrence(b).startDateTime();
+    }
+
 private Q_SLOTS:
     void initTestCase()
     {
@@ -305,6 +333,195 @@ private Q_SLOTS:
         QCOMPARE(items[0].displayLabel(), QStringLiteral("Updated item 2"));
     }
 
+    void testItemsForExport()
+    {
+        createTestEvent();
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QList<QOrganizerItemSortOrder> sort;
+        QOrganizerItemFetchHint hint;
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(m_collection.id());
+        QDateTime start(QDate(2013, 11, 30), QTime(0,0,0));
+        QDateTime end(QDate(2014, 1, 1), QTime(0,0,0));
+
+        // detach one occurrence
+        QList<QOrganizerItem> items = m_engine->items(filter, start, end, 100, sort, hint, &error);
+        QCOMPARE(items.count(), 5);
+        QOrganizerItem updateItem = items[2];
+        updateItem.setDisplayLabel("Exported exception");
+        QList<QOrganizerItem> updateItems;
+        updateItems << updateItem;
+        QVERIFY(m_engine->saveItems(&updateItems, QList<QOrganizerItemDetail::DetailType>(), &errorMap, &error));
+
+        // series and exception are returned as stored, without the generated occurrences
+        items = m_engine->itemsForExport(start, end, filter, sort, hint, &error);
+        QCOMPARE(error, QOrganizerManager::NoError);
+        QCOMPARE(items.count(), 2);
+        int events = 0;
+        int exceptions = 0;
+        Q_FOREACH(const QOrganizerItem &item, items) {
+            if (item.type() == QOrganizerItemType::TypeEvent) {
+                QVERIFY(!QOrganizerEvent(item).recurrenceRules().isEmpty());
+                events++;
+            } else if (item.type() == QOrganizerItemType::TypeEventOccurrence) {
+                QCOMPARE(item.displayLabel(), QStringLiteral("Exported exception"));
+                exceptions++;
+            }
+        }
+        QCOMPARE(events, 1);
+        QCOMPARE(exceptions, 1);
+
+        // nothing stored outside of the series
+        items = m_engine->itemsForExport(QDateTime(QDate(2014, 2, 1), QTime(0,0,0)),
+                                         QDateTime(QDate(2014, 3, 1), QTime(0,0,0)),
+                                         filter, sort, hint, &error);
+        QCOMPARE(items.count(), 0);
+    }
+
+    void testExportItems()
+    {
+        createTestEvent();
+
+        qRegisterMetaType<QOrganizerCollectionId>();
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QSignalSpy progress(m_engine, SIGNAL(exportProgress(QtOrganizer::QOrganizerCollectionId, int)));
+
+        QtOrganizer::QOrganizerManager::Error error;
+        bool exportResult = m_engine->exportItems(&buffer,
+                                                  QList<QOrganizerCollectionId>() << m_collection.id(),
+                                                  &error);
+        QVERIFY(exportResult);
+        QCOMPARE(error, QOrganizerManager::NoError);
+        QVERIFY(progress.count() > 0);
+        QCOMPARE(progress.last().at(1).toInt(), 1);
+
+        QString data = QString::fromUtf8(buffer.data());
+        QVERIFY(data.startsWith("BEGIN:VCALENDAR\r\n"));
+        QVERIFY(data.endsWith("END:VCALENDAR\r\n"));
+        QCOMPARE(data.count("BEGIN:VEVENT"), 1);
+        QVERIFY(data.contains("SUMMARY:Recurrence event test"));
+        QVERIFY(data.contains("RRULE:"));
+        // the timezone used by the event is exported with it
+        QCOMPARE(data.count("BEGIN:VTIMEZONE"), 1);
+        QVERIFY(data.contains("America/Recife"));
+
+        QBuffer closed;
+        QVERIFY(!m_engine->exportItems(&closed, QList<QOrganizerCollectionId>(), &error));
+        QCOMPARE(error, QOrganizerManager::BadArgumentError);
+    }
+
+    void testImportItems()
+    {
+        QByteArray data("BEGIN:VCALENDAR\r\n"
+                        "VERSION:2.0\r\n"
+                        "BEGIN:VEVENT\r\n"
+                        "UID:import-series\r\n"
+                        "DTSTART:20140106T100000Z\r\n"
+                        "DTEND:20140106T110000Z\r\n"
+                        "RRULE:FREQ=WEEKLY;COUNT=3\r\n"
+                        "SUMMARY:Imported series\r\n"
+                        "END:VEVENT\r\n"
+                        "BEGIN:VEVENT\r\n"
+                        "UID:import-single\r\n"
+                        "DTSTART:20140108T100000Z\r\n"
+                        "DTEND:20140108T110000Z\r\n"
+                        "SUMMARY:Imported event\r\n"
+                        "END:VEVENT\r\n"
+                        "BEGIN:VTODO\r\n"
+                        "UID:import-todo\r\n"
+                        "SUMMARY:Not an event\r\n"
+                        "END:VTODO\r\n"
+                        "BEGIN:VEVENT\r\n"
+                        "UID:import-series\r\n"
+                        "RECURRENCE-ID:20140113T100000Z\r\n"
+                        "DTSTART:20140113T120000Z\r\n"
+                        "DTEND:20140113T130000Z\r\n"
+                        "SUMMARY:Imported exception\r\n"
+                        "END:VEVENT\r\n"
+                        "END:VCALENDAR\r\n");
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        bool importResult = m_engine->importItems(&buffer, m_collection.id(), &errorMap, &error);
+        QVERIFY(!importResult);
+        QCOMPARE(error, QOrganizerManager::InvalidItemTypeError);
+        QCOMPARE(errorMap.size(), 1);
+        QCOMPARE(errorMap.value(2), QOrganizerManager::InvalidItemTypeError);
+
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(m_collection.id());
+        QList<QOrganizerItem> items = m_engine->items(filter,
+                                                      QDateTime(QDate(2014, 1, 1), QTime(0,0,0)),
+                                                      QDateTime(QDate(2014, 2, 1), QTime(0,0,0)),
+                                                      100,
+                                                      QList<QOrganizerItemSortOrder>(),
+                                                      QOrganizerItemFetchHint(),
+                                                      &error);
+        QCOMPARE(items.size(), 4);
+        QStringList labels;
+        Q_FOREACH(const QOrganizerItem &item, items) {
+            labels << item.displayLabel();
+        }
+        QCOMPARE(labels.count(QStringLiteral("Imported series")), 2);
+        QCOMPARE(labels.count(QStringLiteral("Imported exception")), 1);
+        QCOMPARE(labels.count(QStringLiteral("Imported event")), 1);
+
+        // importing again reports the items already created
+        buffer.seek(0);
+        importResult = m_engine->importItems(&buffer, m_collection.id(), &errorMap, &error);
+        QVERIFY(!importResult);
+        QCOMPARE(errorMap.value(0), QOrganizerManager::AlreadyExistsError);
+        QCOMPARE(errorMap.value(1), QOrganizerManager::AlreadyExistsError);
+        QCOMPARE(errorMap.value(2), QOrganizerManager::InvalidItemTypeError);
+    }
+
+    void testExportImportTimeZone()
+    {
+        createTestEvent();
+
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QtOrganizer::QOrganizerManager::Error error;
+        QVERIFY(m_engine->exportItems(&buffer,
+                                      QList<QOrganizerCollectionId>() << m_collection.id(),
+                                      &error));
+        buffer.close();
+
+        // the timezone comes before the event using it
+        QString data = QString::fromUtf8(buffer.data());
+        QVERIFY(data.indexOf("BEGIN:VTIMEZONE") >= 0);
+        QVERIFY(data.indexOf("BEGIN:VTIMEZONE") < data.indexOf("BEGIN:VEVENT"));
+
+        QOrganizerCollection collection;
+        collection.setMetaData(QOrganizerCollection::KeyName, uniqueCollectionName());
+        QVERIFY(m_engine->saveCollection(&collection, &error));
+
+        buffer.open(QIODevice::ReadOnly);
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QVERIFY(m_engine->importItems(&buffer, collection.id(), &errorMap, &error));
+        QCOMPARE(errorMap.size(), 0);
+
+        QOrganizerItemCollectionFilter filter;
+        filter.setCollectionId(collection.id());
+        QList<QOrganizerItem> items = m_engine->items(filter,
+                                                      QDateTime(QDate(2013, 11, 30), QTime(0,0,0)),
+                                                      QDateTime(QDate(2014, 1, 1), QTime(0,0,0)),
+                                                      100,
+                                                      QList<QOrganizerItemSortOrder>(),
+                                                      QOrganizerItemFetchHint(),
+                                                      &error);
+        QCOMPARE(items.size(), 5);
+        qSort(items.begin(), items.end(), startDateLessThan);
+        QDateTime start(QDate(2013, 12, 2), QTime(0,0,0), QTimeZone("America/Recife"));
+        QCOMPARE(QOrganizerEventOccurrence(items[0]).startDateTime().toUTC(), start.toUTC());
+        QCOMPARE(QOrganizerEventOccurrence(items[4]).startDateTime().toUTC(), start.addDays(28).toUTC());
+    }
+
     void testModifyReccurenceEventsWithTimeZone()
     {
         // Create event
@@ -775,6 +992,132 @@ private Q_SLOTS:
         QCOMPARE(ocurr1.description(), QString("%1 modified").arg(descriptionValue));
         QVERIFY(!ocurr1.id().isNull());
     }
+
+    void testLocalExpansion()
+    {
+        static const QDateTime startInteval(QDateTime(QDate(2013, 12, 2), QTime(0,0,0), QTimeZone("America/Recife")));
+        static const QDateTime endInteval(QDateTime(QDate(2014, 1, 1), QTime(0,0,0), QTimeZone("America/Recife")));
+
+        QOrganizerItem item = createTestEvent();
+
+        // detach the third occurrence
+        QList<QOrganizerItem> items = fetchOccurrences(startInteval, endInteval, false);
+        QCOMPARE(items.count(), 5);
+        QOrganizerEventOccurrence exception = items[2];
+        exception.setDisplayLabel(QStringLiteral("Detached occurrence"));
+        exception.setStartDateTime(exception.startDateTime().addSecs(3600));
+        exception.setEndDateTime(exception.endDateTime().addSecs(3600));
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QList<QOrganizerItem> saveItems;
+        saveItems << exception;
+        QVERIFY(m_engine->saveItems(&saveItems,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+
+        // both paths must return the same occurrences
+        QList<QOrganizerItem> remote = fetchOccurrences(startInteval, endInteval, false);
+        QList<QOrganizerItem> local = fetchOccurrences(startInteval, endInteval, true);
+        QCOMPARE(local.count(), 5);
+        QCOMPARE(local.count(), remote.count());
+        for (int i = 0; i < local.count(); i++) {
+            QOrganizerEventOccurrence l = local[i];
+            QOrganizerEventOccurrence r = remote[i];
+            QCOMPARE(l.type(), QOrganizerItemType::TypeEventOccurrence);
+            QCOMPARE(l.id(), r.id());
+            QCOMPARE(l.parentId(), r.parentId());
+            QCOMPARE(l.parentId(), item.id());
+            QCOMPARE(l.startDateTime(), r.startDateTime());
+            QCOMPARE(l.endDateTime(), r.endDateTime());
+            QCOMPARE(l.displayLabel(), r.displayLabel());
+            QCOMPARE(l.description(), r.description());
+        }
+        QCOMPARE(local[2].displayLabel(), QStringLiteral("Detached occurrence"));
+    }
+
+    void testLocalExpansionExceptionMovedOut()
+    {
+        static const QDateTime startInteval(QDateTime(QDate(2013, 12, 2), QTime(0,0,0), QTimeZone("America/Recife")));
+        static const QDateTime endInteval(QDateTime(QDate(2014, 1, 1), QTime(0,0,0), QTimeZone("America/Recife")));
+
+        createTestEvent();
+
+        // move the third occurrence after the interval
+        QList<QOrganizerItem> items = fetchOccurrences(startInteval, endInteval, false);
+        QCOMPARE(items.count(), 5);
+        QOrganizerEventOccurrence exception = items[2];
+        QDateTime originalStart = exception.startDateTime();
+        exception.setStartDateTime(endInteval.addDays(10));
+        exception.setEndDateTime(endInteval.addDays(10).addSecs(1800));
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QList<QOrganizerItem> saveItems;
+        saveItems << exception;
+        QVERIFY(m_engine->saveItems(&saveItems,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+
+        // the original slot of the moved occurrence must not be expanded again
+        QList<QOrganizerItem> remote = fetchOccurrences(startInteval, endInteval, false);
+        QList<QOrganizerItem> local = fetchOccurrences(startInteval, endInteval, true);
+        QCOMPARE(remote.count(), 4);
+        QCOMPARE(local.count(), 4);
+        Q_FOREACH(const QOrganizerItem &item, local) {
+            QVERIFY(QOrganizerEventOccurrence(item).startDateTime() != originalStart);
+        }
+    }
+
+    void testExpansionBenchmark_data()
+    {
+        QTest::addColumn<bool>("localExpansion");
+
+        QTest::newRow("generate instances") << false;
+        QTest::newRow("local expansion") << true;
+    }
+
+    void testExpansionBenchmark()
+    {
+        QFETCH(bool, localExpansion);
+        static const QDateTime startInteval(QDateTime(QDate(2013, 1, 1), QTime(0,0,0)));
+        static const QDateTime endInteval(QDateTime(QDate(2014, 1, 1), QTime(0,0,0)));
+
+        // a year view with a daily and a weekly series
+        QList<QOrganizerItem> items;
+        QOrganizerEvent daily;
+        daily.setCollectionId(m_collection.id());
+        daily.setStartDateTime(QDateTime(QDate(2013, 1, 1), QTime(9,0,0)));
+        daily.setEndDateTime(QDateTime(QDate(2013, 1, 1), QTime(9,30,0)));
+        daily.setDisplayLabel(QStringLiteral("Daily benchmark"));
+        QOrganizerRecurrenceRule dailyRule;
+        dailyRule.setFrequency(QOrganizerRecurrenceRule::Daily);
+        daily.setRecurrenceRule(dailyRule);
+        items << daily;
+
+        QOrganizerEvent weekly = daily;
+        weekly.setDisplayLabel(QStringLiteral("Weekly benchmark"));
+        QOrganizerRecurrenceRule weeklyRule;
+        weeklyRule.setFrequency(QOrganizerRecurrenceRule::Weekly);
+        weeklyRule.setDaysOfWeek(QSet<Qt::DayOfWeek>() << Qt::Tuesday);
+        weekly.setRecurrenceRule(weeklyRule);
+        items << weekly;
+
+        QtOrganizer::QOrganizerManager::Error error;
+        QMap<int, QtOrganizer::QOrganizerManager::Error> errorMap;
+        QVERIFY(m_engine->saveItems(&items,
+                                    QList<QtOrganizer::QOrganizerItemDetail::DetailType>(),
+                                    &errorMap,
+                                    &error));
+
+        QList<QOrganizerItem> occurrences;
+        QBENCHMARK {
+            occurrences = fetchOccurrences(startInteval, endInteval, localExpansion);
+        }
+        QCOMPARE(occurrences.count(), 365 + 53);
+    }
 };
 
 QTEST_MAIN(RecurrenceTest)